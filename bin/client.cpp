@@ -1,11 +1,18 @@
+#include "affinity.hpp"
 #include "asio-coro.hpp"
+#include "benchmark_result.hpp"
+#include "histogram.hpp"
 #include "literals.hpp"
 #include "run.hpp"
+#include "zerocopy.hpp"
 
 #include <boost/asio/error.hpp>
 #include <boost/program_options.hpp>
 
+#include <charconv>
+#include <deque>
 #include <iostream>
+#include <numeric>
 #include <ranges>
 #include <thread>
 
@@ -19,12 +26,27 @@ struct ClientConfig
    size_t buffer_size = 64_k;
    std::optional<size_t> size;
    std::optional<steady_clock::duration> duration = 1s;
+   bool ping_pong = false;
+   size_t message_size = 64;
+   std::optional<double> rate; // messages per second, open-loop
+   bool churn = false;
+   bool zerocopy = false; // MSG_ZEROCOPY in throughput mode
 };
 
 class Client
 {
 public:
-   explicit Client(ClientConfig config) : config_(config) { assert(config_.buffer_size > 0); }
+   explicit Client(ClientConfig config) : config_(config)
+   {
+      assert(config_.buffer_size > 0);
+      assert(config_.message_size > 0);
+   }
+
+   /// Round-trip latencies in nanoseconds, recorded in ping-pong, rate limited and churn mode only.
+   const Histogram& latency() const { return latency_; }
+
+   /// Connect latencies in nanoseconds, recorded in churn mode only.
+   const Histogram& connect_latency() const { return connect_latency_; }
 
 private:
    /*
@@ -40,10 +62,23 @@ private:
          const auto data = std::views::iota(uint8_t{0}) | // 0..255, 0..255, ...
                            std::views::take(config_.buffer_size) | //
                            std::ranges::to<std::vector>();
-         while (total < size)
+         if (config_.zerocopy && enable_zerocopy(socket))
+         {
+            // send_zerocopy() doesn't throw on cancellation, but returns what has been sent
+            auto cs = co_await this_coro::cancellation_state;
+            while (total < size && cs.cancelled() == cancellation_type::none)
+            {
+               const size_t n = std::min(size - total, data.size());
+               total += co_await send_zerocopy(socket, buffer(data, n));
+            }
+         }
+         else
          {
-            const size_t n = std::min(total - size, data.size());
-            total += co_await socket.async_write_some(buffer(data, n));
+            while (total < size)
+            {
+               const size_t n = std::min(size - total, data.size());
+               total += co_await socket.async_write_some(buffer(data, n));
+            }
          }
       }
       catch (system_error& ex)
@@ -60,13 +95,173 @@ private:
       co_return total;
    }
 
-   awaitable<size_t> write(tcp::socket& socket)
+   /// Runs \p task until it completes or the configured duration has elapsed.
+   awaitable<size_t> limited(awaitable<size_t> task)
    {
       auto executor = co_await this_coro::executor;
       if (config_.duration)
-         co_return co_await co_spawn(executor, write_loop(socket), cancel_after(*config_.duration));
+         co_return co_await co_spawn(executor, std::move(task), cancel_after(*config_.duration));
       else
-         co_return co_await write_loop(socket);
+         co_return co_await std::move(task);
+   }
+
+   awaitable<size_t> write(tcp::socket& socket) { return limited(write_loop(socket)); }
+
+   /*
+    * Send a message of 'message_size' bytes and wait for the complete echo before sending the next
+    * one. The round-trip time of each message is recorded in the latency histogram.
+    *
+    * The echo is read while the message is still being written: A message larger than the socket
+    * buffers would otherwise block the server's write, and then the client's write, too.
+    */
+   awaitable<size_t> ping_pong_loop(tcp::socket& socket)
+   {
+      size_t total = 0;
+      size_t size = config_.size ? *config_.size : std::numeric_limits<size_t>::max();
+      try
+      {
+         const auto message = std::views::iota(uint8_t{0}) | // 0..255, 0..255, ...
+                              std::views::take(config_.message_size) | //
+                              std::ranges::to<std::vector>();
+         std::vector<uint8_t> reply(message.size());
+         while (total < size)
+         {
+            auto t0 = steady_clock::now();
+            co_await (async_write(socket, buffer(message), use_awaitable) &&
+                      async_read(socket, buffer(reply), use_awaitable));
+            latency_.record(steady_clock::now() - t0);
+            total += reply.size();
+         }
+      }
+      catch (system_error& ex)
+      {
+         if (ex.code() != boost::system::errc::operation_canceled)
+            throw;
+      }
+
+      error_code ec;
+      ec = socket.shutdown(boost::asio::socket_base::shutdown_send, ec);
+      co_return total;
+   }
+
+   awaitable<size_t> ping_pong(tcp::socket& socket) { return limited(ping_pong_loop(socket)); }
+
+   using SendTimes = std::deque<steady_clock::time_point>;
+
+   /*
+    * Open-loop load: Send a message every 1/rate seconds on a fixed schedule, regardless of
+    * whether the echoes are keeping up. If a write blocks, the following messages are sent late,
+    * but their intended send time is still taken from the schedule. This way, server stalls show
+    * up as latency instead of being hidden by the client backing off (coordinated omission).
+    */
+   awaitable<size_t> send_loop(tcp::socket& socket, SendTimes& sent)
+   {
+      auto seconds = std::chrono::duration<double>(1.0 / *config_.rate);
+      auto interval = std::max(steady_clock::duration{1},
+                               duration_cast<steady_clock::duration>(seconds));
+
+      size_t total = 0;
+      size_t size = config_.size ? *config_.size : std::numeric_limits<size_t>::max();
+      try
+      {
+         const auto message = std::views::iota(uint8_t{0}) | // 0..255, 0..255, ...
+                              std::views::take(config_.message_size) | //
+                              std::ranges::to<std::vector>();
+         steady_timer timer(co_await this_coro::executor);
+         for (auto next = steady_clock::now(); total < size; next += interval)
+         {
+            timer.expires_at(next);
+            co_await timer.async_wait();
+            sent.push_back(next);
+            co_await async_write(socket, buffer(message));
+            total += message.size();
+         }
+      }
+      catch (system_error& ex)
+      {
+         if (ex.code() != boost::system::errc::operation_canceled)
+            throw;
+      }
+
+      error_code ec;
+      ec = socket.shutdown(boost::asio::socket_base::shutdown_send, ec);
+      co_return total;
+   }
+
+   /// Reads echoed messages until EOF, recording the latency relative to their intended send time.
+   awaitable<size_t> receive_loop(tcp::socket& socket, SendTimes& sent)
+   {
+      size_t total = 0;
+      try
+      {
+         std::vector<uint8_t> reply(config_.message_size);
+         for (;;)
+         {
+            co_await async_read(socket, buffer(reply));
+            assert(!sent.empty());
+            latency_.record(steady_clock::now() - sent.front());
+            sent.pop_front();
+            total += reply.size();
+         }
+      }
+      catch (system_error& ex)
+      {
+         if (ex.code() != asio::error::eof && ex.code() != boost::system::errc::operation_canceled)
+            throw;
+      }
+      co_return total;
+   }
+
+   /*
+    * Connection churn: Connect, echo a single message and close, over and over again. This stresses
+    * the accept loop and session startup of the server instead of the data path.
+    *
+    * The connect latency only covers the TCP handshake, which the kernel completes before the
+    * server accepts the connection. The round-trip latency is measured from starting to connect
+    * until the echo has arrived, so it includes accepting and spawning the session as well.
+    *
+    * The client closes first, so its end of each connection remains in TIME_WAIT. On loopback,
+    * Linux reuses these ports by default (net.ipv4.tcp_tw_reuse), otherwise they may run out.
+    */
+   awaitable<size_t> churn_loop(const tcp::resolver::results_type& endpoints)
+   {
+      auto executor = co_await this_coro::executor;
+      size_t total = 0;
+      try
+      {
+         const auto message = std::views::iota(uint8_t{0}) | // 0..255, 0..255, ...
+                              std::views::take(config_.message_size) | //
+                              std::ranges::to<std::vector>();
+         std::vector<uint8_t> reply(message.size());
+         for (;;)
+         {
+            tcp::socket socket(executor);
+            auto t0 = steady_clock::now();
+            co_await asio::async_connect(socket, endpoints);
+            connect_latency_.record(steady_clock::now() - t0);
+
+            socket.set_option(tcp::no_delay(true));
+            co_await (async_write(socket, buffer(message), use_awaitable) &&
+                      async_read(socket, buffer(reply), use_awaitable));
+            latency_.record(steady_clock::now() - t0);
+            total += reply.size();
+
+            //
+            // Wait for the server to close its end, so that the number of sessions on the server
+            // stays bounded by the number of workers.
+            //
+            socket.shutdown(socket_base::shutdown_send);
+            auto [ec, n] = co_await socket.async_read_some(buffer(reply), as_tuple);
+            if (ec && ec != asio::error::eof)
+               throw system_error(ec);
+         }
+      }
+      catch (system_error& ex)
+      {
+         if (ex.code() != boost::system::errc::operation_canceled)
+            throw;
+      }
+      co_return total;
    }
 
    awaitable<size_t> read(tcp::socket& socket)
@@ -92,6 +287,8 @@ private:
    }
 
    ClientConfig config_;
+   Histogram latency_;
+   Histogram connect_latency_;
 
 public:
    awaitable<size_t> run(std::string host, uint16_t port)
@@ -118,12 +315,47 @@ public:
       std::println("endpoints: {}", range);
 #endif
 
+      if (config_.churn)
+      {
+         auto t0 = steady_clock::now();
+         auto nread = co_await limited(churn_loop(endpoints));
+         auto dt = std::max(1ms, floor<milliseconds>(steady_clock::now() - t0));
+         std::println("{} connections in {} ({:.0f}/s)", connect_latency_.count(), dt,
+                      connect_latency_.count() * 1000.0 / dt.count());
+         co_return nread;
+      }
+
       ip::tcp::socket socket(executor);
       auto endpoint = co_await asio::async_connect(socket, endpoints);
       std::println("connected to: {}", endpoint);
 
       // std::println("connected to {}", socket.remote_endpoint());
 
+      if (config_.rate)
+      {
+         socket.set_option(tcp::no_delay(true));
+         SendTimes sent;
+         auto t0 = steady_clock::now();
+         auto [nwrite, nread] = co_await (limited(send_loop(socket, sent)) && //
+                                          receive_loop(socket, sent));
+         auto dt = std::max(1ms, floor<milliseconds>(steady_clock::now() - t0));
+         std::println("{} messages of {} in {} ({:.0f}/s, target {:.0f}/s): {}", latency_.count(),
+                      Bytes(config_.message_size), dt, latency_.count() * 1000.0 / dt.count(),
+                      *config_.rate, latency_);
+         co_return nread;
+      }
+
+      if (config_.ping_pong)
+      {
+         socket.set_option(tcp::no_delay(true));
+         auto t0 = steady_clock::now();
+         auto nread = co_await ping_pong(socket);
+         auto dt = floor<milliseconds>(steady_clock::now() - t0);
+         std::println("{} round trips of {} in {}: {}", latency_.count(),
+                      Bytes(config_.message_size), dt, latency_);
+         co_return nread;
+      }
+
       auto t0 = steady_clock::now();
       auto [nwrite, nread] = co_await (write(socket) && read(socket));
       auto dt = floor<milliseconds>(steady_clock::now() - t0);
@@ -141,12 +373,178 @@ struct Config
    size_t connections = 1;
    size_t threads = std::thread::hardware_concurrency();
    double duration = 1;
+   size_t buffer_size = 64_k;
+   bool ping_pong = false;
+   size_t message_size = 64;
+   std::string rate;
+   std::string total_rate;
+   std::string sweep;
+   bool churn = false;
+   bool zerocopy = false;
+   bool pin = false;
+   std::string cpus;
+   std::string json;
+   bool debug = false;
+};
+
+/**
+ * Parses a rate given either in messages per second ("20000", "2.5e4") or, with one of the unit
+ * suffixes B, KiB, MiB or GiB, in bytes per second ("10MiB"). Returns messages per second.
+ */
+std::optional<double> parse_rate(const std::string& text, size_t message_size)
+{
+   size_t pos = 0;
+   double value;
+   try
+   {
+      value = std::stod(text, &pos);
+   }
+   catch (std::exception&)
+   {
+      return std::nullopt;
+   }
+
+   auto unit = std::string_view(text).substr(pos);
+   if (unit.empty())
+      ;
+   else if (unit == "B")
+      value /= double(message_size);
+   else if (unit == "KiB")
+      value *= 1_k / double(message_size);
+   else if (unit == "MiB")
+      value *= 1_m / double(message_size);
+   else if (unit == "GiB")
+      value *= 1_g / double(message_size);
+   else
+      return std::nullopt;
+
+   if (!(value > 0.0))
+      return std::nullopt;
+
+   return value;
+}
+
+/// Parses a size in bytes, optionally with one of the unit suffixes B, KiB, MiB or GiB ("16KiB").
+std::optional<size_t> parse_size(std::string_view text)
+{
+   size_t value = 0;
+   auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+   if (ec != std::errc{})
+      return std::nullopt;
+
+   auto unit = std::string_view(end, text.data() + text.size());
+   if (unit.empty() || unit == "B")
+      return value;
+   else if (unit == "KiB")
+      return value * 1_k;
+   else if (unit == "MiB")
+      return value * 1_m;
+   else if (unit == "GiB")
+      return value * 1_g;
+   else
+      return std::nullopt;
+}
+
+/// Parses a sweep range "MIN-MAX", like "16-1MiB". Both must be positive and MIN <= MAX.
+std::optional<std::pair<size_t, size_t>> parse_sweep(std::string_view text)
+{
+   auto dash = text.find('-');
+   if (dash == std::string_view::npos)
+      return std::nullopt;
+
+   auto min = parse_size(text.substr(0, dash));
+   auto max = parse_size(text.substr(dash + 1));
+   if (!min || !max || *min == 0 || *min > *max || *max > 1_g)
+      return std::nullopt;
+
+   return std::pair{*min, *max};
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/// Results of a single run of all connections.
+struct RunResult
+{
+   std::vector<size_t> bytes; // echoed, per connection
+   milliseconds elapsed{};
+   std::optional<Histogram> latency;
+   std::optional<Histogram> connect_latency;
 };
 
+/**
+ * Runs the configured number of connections, spread across the configured number of IO contexts,
+ * until all of them have completed.
+ */
+RunResult run_clients(const Config& config, const ClientConfig& client_config,
+                      const std::vector<unsigned>& cpus)
+{
+   std::vector<io_context> io_contexts(config.threads);
+
+   std::vector<Client> clients;
+   clients.reserve(config.connections);
+
+   auto futures = std::views::iota(size_t{0}, clients.capacity()) |
+                  std::views::transform([&](size_t i) mutable
+   {
+      auto executor = io_contexts[i % io_contexts.size()].get_executor();
+      clients.emplace_back(client_config);
+      return co_spawn(executor, clients.back().run(config.host, config.port), as_tuple(use_future));
+   }) | std::ranges::to<std::vector>();
+
+   //
+   // Run the IO contexts until there is no pending operation left.
+   //
+   if (config.debug)
+   {
+      assert(io_contexts.size() == 1);
+      runDebug(io_contexts[0]);
+      exit(0);
+   }
+
+   auto t0 = steady_clock::now();
+   std::vector<std::jthread> threads;
+   for (size_t i = 0; i < io_contexts.size(); ++i)
+      threads.emplace_back([&context = io_contexts[i], &cpus, i]()
+      {
+         if (!cpus.empty())
+            pin_this_thread(cpus[i % cpus.size()]);
+         context.run();
+      });
+
+   RunResult result;
+   for (auto& future : futures)
+   {
+      auto [ec, bytes] = future.get();
+      result.bytes.push_back(bytes);
+      if (ec)
+         std::println("ERROR: {}", what(ec));
+   }
+   result.elapsed = std::max(1ms, floor<milliseconds>(steady_clock::now() - t0));
+   threads.clear(); // join before the IO contexts are destroyed
+
+   //
+   // All clients have completed, so their histograms can be merged safely across IO contexts.
+   //
+   if (client_config.ping_pong || client_config.rate || client_config.churn)
+   {
+      result.latency.emplace();
+      for (const auto& client : clients)
+         result.latency->merge(client.latency());
+   }
+   if (client_config.churn)
+   {
+      result.connect_latency.emplace();
+      for (const auto& client : clients)
+         result.connect_latency->merge(client.connect_latency());
+   }
+   return result;
+}
+
+// =================================================================================================
+
 int main(int argc, char* argv[])
 {
    Config config;
-   bool debug = false;
 
    //
    // Define and parse command line options.
@@ -169,7 +567,38 @@ int main(int argc, char* argv[])
       "duration,d",
       po::value(&config.duration)->default_value(config.duration)->value_name("SECONDS"),
       "number of seconds to run the test before closing the connection");
-   desc.add_options()("debug", po::bool_switch(&debug),
+   desc.add_options()(
+      "buffer-size,b",
+      po::value(&config.buffer_size)->default_value(config.buffer_size)->value_name("BYTES"),
+      "size of the read and write buffers in throughput mode");
+   desc.add_options()("zerocopy", po::bool_switch(&config.zerocopy),
+                      "send with MSG_ZEROCOPY in throughput mode, which pays off only for large "
+                      "buffers over a real network (on loopback, the kernel copies anyway)");
+   desc.add_options()("ping-pong", po::bool_switch(&config.ping_pong),
+                      "send one message at a time and wait for its echo, measuring latency");
+   desc.add_options()(
+      "message-size,m",
+      po::value(&config.message_size)->default_value(config.message_size)->value_name("BYTES"),
+      "size of each message in ping-pong and rate limited mode");
+   desc.add_options()("sweep",
+                      po::value(&config.sweep)->implicit_value("16-1MiB")->value_name("MIN-MAX"),
+                      "repeat the test for sizes from MIN to MAX in powers of two, varying the "
+                      "buffer size, or the message size in ping-pong mode (default: 16-1MiB)");
+   desc.add_options()("rate,r", po::value(&config.rate)->value_name("RATE"),
+                      "open-loop mode: send messages at a fixed RATE per connection, in messages/s "
+                      "or with a unit suffix in bytes/s (B, KiB, MiB, GiB), measuring latency");
+   desc.add_options()("total-rate", po::value(&config.total_rate)->value_name("RATE"),
+                      "like --rate, but RATE is split evenly across all connections");
+   desc.add_options()("churn", po::bool_switch(&config.churn),
+                      "connect, echo a single message and close, repeatedly on each of the "
+                      "connections, measuring connections/s and connect latency");
+   desc.add_options()("pin", po::bool_switch(&config.pin),
+                      "pin the thread of each IO context to one of the available CPUs");
+   desc.add_options()("cpus", po::value(&config.cpus)->value_name("LIST"),
+                      "pin IO context threads to the CPUs in LIST, like '0-3,8' (implies --pin)");
+   desc.add_options()("json", po::value(&config.json)->value_name("FILE"),
+                      "write the configuration and results to FILE, one JSON record per line");
+   desc.add_options()("debug", po::bool_switch(&config.debug),
                       "enable debug mode (single threaded with additional logging)");
 
    po::variables_map vm;
@@ -202,57 +631,170 @@ int main(int argc, char* argv[])
       return 1;
    }
 
-   if (debug)
+   if (config.message_size == 0)
+   {
+      std::println("ERROR: message size must be at least 1");
+      return 1;
+   }
+
+   if (config.buffer_size == 0)
+   {
+      std::println("ERROR: buffer size must be at least 1");
+      return 1;
+   }
+
+   std::optional<double> rate;
+   if (!config.rate.empty() && !config.total_rate.empty())
+   {
+      std::println("ERROR: --rate and --total-rate are mutually exclusive");
+      return 1;
+   }
+   else if (!config.rate.empty() || !config.total_rate.empty())
+   {
+      const auto& text = config.rate.empty() ? config.total_rate : config.rate;
+      rate = parse_rate(text, config.message_size);
+      if (!rate)
+      {
+         std::println("ERROR: invalid rate '{}'", text);
+         return 1;
+      }
+      if (!config.total_rate.empty())
+         *rate /= double(config.connections);
+   }
+
+   if (config.churn && (config.ping_pong || rate || !config.sweep.empty()))
+   {
+      std::println("ERROR: --churn cannot be combined with --ping-pong, --rate or --sweep");
+      return 1;
+   }
+
+   std::optional<std::pair<size_t, size_t>> sweep;
+   if (!config.sweep.empty())
+   {
+      if (rate)
+      {
+         std::println("ERROR: --sweep is not supported in rate limited mode");
+         return 1;
+      }
+      sweep = parse_sweep(config.sweep);
+      if (!sweep)
+      {
+         std::println("ERROR: invalid sweep range '{}'", config.sweep);
+         return 1;
+      }
+   }
+
+   std::vector<unsigned> cpus;
+   try
+   {
+      if (!config.cpus.empty())
+      {
+         cpus = parse_cpu_list(config.cpus);
+         check_cpus_available(cpus); // before starting threads, pinning them must not fail
+      }
+      else if (config.pin)
+         cpus = available_cpus();
+   }
+   catch (const std::exception& ex)
+   {
+      std::println("ERROR: {}", ex.what());
+      return 1;
+   }
+
+   if (config.debug)
    {
       config.threads = 1;
       std::println("DEBUG mode enabled");
    }
-
-   //
-   // Create IO context with the configured number of concurrent connections.
-   //
    config.threads = std::min(config.threads, config.connections);
-   std::vector<io_context> io_contexts(config.threads);
 
-   std::vector<Client> clients;
-   clients.reserve(config.connections);
+   auto duration = std::chrono::duration<double>(config.duration);
+   ClientConfig client_config{.buffer_size = config.buffer_size,
+                              .duration = duration_cast<steady_clock::duration>(duration),
+                              .ping_pong = config.ping_pong,
+                              .message_size = config.message_size,
+                              .rate = rate,
+                              .churn = config.churn,
+                              .zerocopy = config.zerocopy};
 
-   auto futures = std::views::iota(size_t{0}, clients.capacity()) |
-                  std::views::transform([&](size_t i) mutable
+   auto to_result = [&](RunResult run)
    {
-      auto executor = io_contexts[i % io_contexts.size()].get_executor();
-      auto durationDouble = std::chrono::duration<double>(config.duration);
-      auto duration = duration_cast<steady_clock::duration>(durationDouble);
-      clients.emplace_back(ClientConfig{.duration = duration});
-      return co_spawn(executor, clients.back().run(config.host, config.port), as_tuple(use_future));
-   }) | std::ranges::to<std::vector>();
+      return BenchmarkResult{
+         .client = "client",
+         .mode = rate               ? "rate"
+                 : config.ping_pong ? "ping-pong"
+                 : config.churn     ? "churn"
+                                    : "throughput",
+         .host = config.host,
+         .port = config.port,
+         .connections = config.connections,
+         .threads = config.threads,
+         .duration = config.duration,
+         .buffer_size = client_config.buffer_size,
+         .message_size = client_config.message_size,
+         .rate = rate,
+         .bytes = std::move(run.bytes),
+         .elapsed = run.elapsed,
+         .latency = std::move(run.latency),
+         .connect_latency = std::move(run.connect_latency),
+      };
+   };
 
-   //
-   // Finally, run the configured number of IO contexts until there is no pending operation left.
-   //
-   if (debug)
+   std::vector<BenchmarkResult> results;
+   if (!sweep)
    {
-      assert(io_contexts.size() == 1);
-      runDebug(io_contexts[0]);
-      exit(0);
+      auto run = run_clients(config, client_config, cpus);
+      auto total = std::accumulate(run.bytes.begin(), run.bytes.end(), size_t{0});
+      std::println("Total bytes echoed: {} at {} MiB/s", Bytes(total),
+                   total * 1000 / 1024 / 1024 / run.elapsed.count());
+      if (run.connect_latency)
+         std::println("Connections: {} at {:.0f}/s, connect latency: {}",
+                      run.connect_latency->count(),
+                      run.connect_latency->count() * 1000.0 / run.elapsed.count(),
+                      *run.connect_latency);
+      if (run.latency)
+         std::println("{} latency: {}", rate ? "Open-loop" : "Round-trip", *run.latency);
+      results.push_back(to_result(std::move(run)));
    }
    else
    {
-      auto t0 = steady_clock::now();
-      for (auto& context : io_contexts)
-         std::jthread([&context]() { context.run(); }).detach();
-
-      size_t total = 0;
-      for (auto& future : futures)
+      //
+      // Small messages are dominated by the per-operation overhead, large ones by copying. In
+      // throughput mode, each write (and read) transfers one buffer, so the buffer size is the
+      // message size. In ping-pong mode, the message size is varied directly.
+      //
+      std::vector<std::string> lines;
+      for (size_t size = sweep->first; size <= sweep->second; size *= 2)
       {
-         auto [ec, bytes] = future.get();
-         total += bytes;
-         if (ec)
-            std::println("ERROR: {}", what(ec));
+         (config.ping_pong ? client_config.message_size : client_config.buffer_size) = size;
+         auto run = run_clients(config, client_config, cpus);
+         auto total = std::accumulate(run.bytes.begin(), run.bytes.end(), size_t{0});
+         auto seconds = double(run.elapsed.count()) / 1000.0;
+         auto line = std::format("{:>12}: {:10.1f} MiB/s {:12.0f} messages/s",
+                                 std::format("{}", Bytes(size)), double(total) / 1_m / seconds,
+                                 double(total) / double(size) / seconds);
+         if (run.latency)
+            line += std::format("  {}", *run.latency);
+         lines.push_back(std::move(line));
+         results.push_back(to_result(std::move(run)));
       }
 
-      auto dt = std::max(1ms, floor<milliseconds>(steady_clock::now() - t0));
-      std::println("Total bytes echoed: {} at {} MiB/s", Bytes(total),
-                   total * 1000 / 1024 / 1024 / dt.count());
+      std::println("\nSweep over {} connection(s), {}s each:", config.connections,
+                   config.duration);
+      for (const auto& line : lines)
+         std::println("{}", line);
+   }
+
+   if (!config.json.empty())
+   {
+      try
+      {
+         write_json(results, config.json);
+      }
+      catch (const std::exception& ex)
+      {
+         std::println("ERROR: {}", ex.what());
+         return 1;
+      }
    }
 }
@@ -1,3 +1,4 @@
+#include "benchmark_result.hpp"
 #include "formatters.hpp"
 
 #include <boost/capy.hpp>
@@ -7,7 +8,6 @@
 #include <boost/system/error_code.hpp>
 
 #include <algorithm>
-#include <atomic>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
@@ -143,7 +143,7 @@ capy::task<SessionStats> run_session(corosio::io_context& ioc, ClientConfig conf
 }
 
 capy::task<void> client_task(corosio::io_context& ioc, ClientConfig config, std::string host,
-                             uint16_t port, std::atomic<size_t>& total_bytes)
+                             uint16_t port, size_t& bytes)
 {
    auto stats = co_await run_session(ioc, config, std::move(host), port);
    if (stats.connected)
@@ -153,7 +153,7 @@ capy::task<void> client_task(corosio::io_context& ioc, ClientConfig config, std:
       std::println("wrote {} and read {} (Δ {}) in {}ms", Bytes(stats.written), Bytes(stats.read),
                    delta, elapsed_ms.count());
    }
-   total_bytes.fetch_add(stats.read, std::memory_order_relaxed);
+   bytes = stats.read;
 }
 
 struct Config
@@ -163,6 +163,8 @@ struct Config
    size_t connections = 1;
    size_t threads = std::thread::hardware_concurrency();
    double duration = 1.0;
+   size_t buffer_size = 64 * 1024;
+   std::string json;
 };
 
 int main(int argc, char* argv[])
@@ -182,7 +184,12 @@ int main(int argc, char* argv[])
       "number of IO contexts to run in parallel")(
       "duration,d",
       po::value(&config.duration)->default_value(config.duration)->value_name("SECONDS"),
-      "number of seconds to run before closing the connection");
+      "number of seconds to run before closing the connection")(
+      "buffer-size,b",
+      po::value(&config.buffer_size)->default_value(config.buffer_size)->value_name("BYTES"),
+      "size of the read and write buffers")(
+      "json", po::value(&config.json)->value_name("FILE"),
+      "write the configuration and results as a JSON record to FILE");
 
    po::variables_map vm;
    try
@@ -220,12 +227,19 @@ int main(int argc, char* argv[])
       return 1;
    }
 
+   if (config.buffer_size == 0)
+   {
+      std::cerr << "ERROR: buffer size must be at least 1\n";
+      return 1;
+   }
+
    config.threads = std::min(config.threads, config.connections);
 
    std::vector<corosio::io_context> io_contexts(config.threads);
-   std::atomic<size_t> total_bytes{0};
+   std::vector<size_t> bytes(config.connections); // per connection
 
    ClientConfig client_config;
+   client_config.buffer_size = config.buffer_size;
    if (config.duration > 0.0)
    {
       auto duration = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
@@ -241,7 +255,7 @@ int main(int argc, char* argv[])
    {
       auto& ioc = io_contexts[i % io_contexts.size()];
       capy::run_async(ioc.get_executor())(
-         client_task(ioc, client_config, config.host, config.port, total_bytes));
+         client_task(ioc, client_config, config.host, config.port, bytes[i]));
    }
 
    auto start = std::chrono::steady_clock::now();
@@ -252,14 +266,41 @@ int main(int argc, char* argv[])
       threads.emplace_back([&ioc = io_contexts[i]]() { ioc.run(); });
 
    io_contexts[0].run();
+   threads.clear(); // join
 
    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
       std::chrono::steady_clock::now() - start);
    auto ms = std::max<int64_t>(elapsed.count(), 1);
-   auto mib_per_s = static_cast<double>(total_bytes.load()) * 1000.0 / 1024.0 / 1024.0 / ms;
+   auto total_bytes = std::accumulate(bytes.begin(), bytes.end(), size_t{0});
+   auto mib_per_s = static_cast<double>(total_bytes) * 1000.0 / 1024.0 / 1024.0 / ms;
 
-   std::println("Total bytes echoed: {} at {} MiB/s", Bytes(total_bytes.load()),
+   std::println("Total bytes echoed: {} at {} MiB/s", Bytes(total_bytes),
                 static_cast<int64_t>(mib_per_s));
 
+   if (!config.json.empty())
+   {
+      BenchmarkResult result{
+         .client = "corosio_client",
+         .mode = "throughput",
+         .host = config.host,
+         .port = config.port,
+         .connections = config.connections,
+         .threads = config.threads,
+         .duration = config.duration,
+         .buffer_size = config.buffer_size,
+         .bytes = std::move(bytes),
+         .elapsed = elapsed,
+      };
+      try
+      {
+         write_json(result, config.json);
+      }
+      catch (const std::exception& ex)
+      {
+         std::cerr << "ERROR: " << ex.what() << "\n";
+         return 1;
+      }
+   }
+
    return 0;
 }
\ No newline at end of file
@@ -0,0 +1,330 @@
+/**
+ * HTTP/1.1 load generator for the servers in the http directory.
+ *
+ * Each connection sends the same request over and over again, keeping up to --pipeline requests
+ * in flight. Latency is measured from sending a request until its response has been received
+ * completely, and reported per status code. Like bin/client, the connections are distributed
+ * across one IO context per thread.
+ *
+ * bin/http_client --body test/data/64KB-min.json --connections 8 --pipeline 4
+ */
+#include "asio-coro.hpp"
+#include "histogram.hpp"
+#include "literals.hpp"
+
+#include <boost/beast/core/flat_buffer.hpp>
+#include <boost/beast/http.hpp>
+#include <boost/program_options.hpp>
+
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <ranges>
+#include <sstream>
+#include <thread>
+
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace beast = boost::beast;
+namespace http = beast::http;
+namespace po = boost::program_options;
+
+struct ClientConfig
+{
+   std::string request; // serialized once, sent as is
+   bool head = false; // responses have no body, regardless of their Content-Length
+   size_t pipeline = 1;
+   steady_clock::duration duration = 1s;
+};
+
+/// Request and response counts plus latencies, per connection or merged across all of them.
+struct Statistics
+{
+   size_t requests = 0;
+   size_t bytes = 0; // received, including headers
+   std::map<unsigned, Histogram> latency; // by status code
+
+   void merge(const Statistics& other)
+   {
+      requests += other.requests;
+      bytes += other.bytes;
+      for (const auto& [status, histogram] : other.latency)
+         latency[status].merge(histogram);
+   }
+};
+
+class Client
+{
+public:
+   explicit Client(const ClientConfig& config) : config_(config) { assert(config_.pipeline > 0); }
+
+   const Statistics& statistics() const { return statistics_; }
+
+private:
+   using SendTimes = std::deque<steady_clock::time_point>;
+
+   /*
+    * Sends requests until the configured duration has elapsed, waiting whenever the configured
+    * number of requests is in flight. Afterwards, shuts down the sending side so that the server
+    * closes the connection as soon as it has responded to all requests.
+    *
+    * The duration is checked between requests instead of cancelling, which could leave a
+    * partially written request behind.
+    */
+   awaitable<void> write_loop(tcp::socket& socket, SendTimes& sent, steady_timer& space)
+   {
+      auto deadline = steady_clock::now() + config_.duration;
+      while (steady_clock::now() < deadline)
+      {
+         if (sent.size() >= config_.pipeline)
+         {
+            space.expires_at(deadline); // woken up early by read_loop()
+            co_await space.async_wait(as_tuple);
+            continue;
+         }
+         sent.push_back(steady_clock::now());
+         co_await async_write(socket, buffer(config_.request));
+      }
+
+      error_code ec;
+      ec = socket.shutdown(socket_base::shutdown_send, ec);
+   }
+
+   /**
+    * Reads responses until the server closes the connection, recording their latencies. Requests
+    * still unanswered by then are reported as an error.
+    */
+   awaitable<void> read_loop(tcp::socket& socket, SendTimes& sent, steady_timer& space)
+   {
+      beast::flat_buffer buffer;
+      try
+      {
+         for (;;)
+         {
+            http::response_parser<http::string_body> parser;
+            parser.body_limit(boost::none);
+            parser.skip(config_.head);
+            statistics_.bytes += co_await http::async_read(socket, buffer, parser);
+            assert(!sent.empty());
+            statistics_.latency[parser.get().result_int()].record(steady_clock::now() -
+                                                                   sent.front());
+            statistics_.requests++;
+            sent.pop_front();
+            space.cancel();
+         }
+      }
+      catch (system_error& ex)
+      {
+         if (ex.code() != http::error::end_of_stream && ex.code() != asio::error::eof)
+            throw;
+      }
+      if (!sent.empty())
+         throw std::runtime_error(
+            std::format("connection closed with {} request(s) unanswered", sent.size()));
+   }
+
+   const ClientConfig& config_;
+   Statistics statistics_;
+
+public:
+   awaitable<void> run(std::string host, uint16_t port)
+   {
+      auto executor = co_await this_coro::executor;
+      tcp::resolver resolver(executor);
+      auto endpoints = co_await resolver.async_resolve(host, std::to_string(port));
+
+      tcp::socket socket(executor);
+      co_await asio::async_connect(socket, endpoints);
+      socket.set_option(tcp::no_delay(true));
+
+      SendTimes sent;
+      steady_timer space(executor);
+      co_await (write_loop(socket, sent, space) && read_loop(socket, sent, space));
+   }
+};
+
+struct Config
+{
+   std::string host = "127.0.0.1";
+   uint16_t port = 55555;
+   size_t connections = 1;
+   size_t threads = std::thread::hardware_concurrency();
+   double duration = 1;
+   size_t pipeline = 1;
+   std::string method;
+   std::string target = "/";
+   std::string body;
+   std::string content_type = "application/json";
+};
+
+/// Reads the whole file at \p path, throwing if it cannot be opened.
+std::string read_file(const std::string& path)
+{
+   std::ifstream file(path, std::ios::binary);
+   if (!file)
+      throw std::runtime_error(std::format("cannot open '{}'", path));
+   std::ostringstream content;
+   content << file.rdbuf();
+   return std::move(content).str();
+}
+
+/// Serializes the request that is sent over and over again, including its header.
+std::string make_request(const Config& config)
+{
+   http::request<http::string_body> request;
+   request.method_string(config.method.empty() ? (config.body.empty() ? "GET" : "POST")
+                                               : config.method);
+   request.target(config.target);
+   request.set(http::field::host, config.host);
+   request.set(http::field::user_agent, "http_client");
+   if (!config.body.empty())
+   {
+      request.set(http::field::content_type, config.content_type);
+      request.body() = read_file(config.body);
+   }
+   request.keep_alive(true);
+   request.prepare_payload();
+
+   std::ostringstream wire;
+   wire << request;
+   return std::move(wire).str();
+}
+
+// =================================================================================================
+
+int main(int argc, char* argv[])
+{
+   Config config;
+
+   //
+   // Define and parse command line options.
+   //
+   po::options_description desc("Allowed options");
+   desc.add_options()("help,h", "produce help message");
+   desc.add_options()("host", po::value<std::string>(&config.host)->default_value(config.host),
+                      "host to connect to");
+   desc.add_options()("port,p",
+                      po::value(&config.port)->default_value(config.port)->value_name("PORT"),
+                      "port number");
+   desc.add_options()(
+      "connections,c",
+      po::value(&config.connections)->default_value(config.connections)->value_name("N"),
+      "number of connections");
+   desc.add_options()("threads,t",
+                      po::value(&config.threads)->default_value(config.threads)->value_name("N"),
+                      "number of IO contexts to run in parallel");
+   desc.add_options()(
+      "duration,d",
+      po::value(&config.duration)->default_value(config.duration)->value_name("SECONDS"),
+      "number of seconds to send requests");
+   desc.add_options()(
+      "pipeline,P",
+      po::value(&config.pipeline)->default_value(config.pipeline)->value_name("DEPTH"),
+      "number of requests in flight per connection, 1 disables pipelining");
+   desc.add_options()("target", po::value(&config.target)->default_value(config.target),
+                      "request target (path)");
+   desc.add_options()("body,B", po::value(&config.body)->value_name("FILE"),
+                      "send the contents of FILE as the body of each request");
+   desc.add_options()("content-type",
+                      po::value(&config.content_type)->default_value(config.content_type),
+                      "content type of the body");
+   desc.add_options()("method,X", po::value(&config.method)->value_name("METHOD"),
+                      "request method (default: POST with --body, GET otherwise)");
+
+   po::variables_map vm;
+   try
+   {
+      po::store(po::parse_command_line(argc, argv, desc), vm);
+      po::notify(vm);
+   }
+   catch (const po::error& ex)
+   {
+      std::println(std::cerr, "Command line error: {}", ex.what());
+      return 1;
+   }
+
+   if (vm.count("help"))
+   {
+      desc.print(std::cout);
+      return 1;
+   }
+
+   if (config.threads == 0 || config.connections == 0 || config.pipeline == 0)
+   {
+      std::println("ERROR: threads, connections and pipeline depth must be at least 1");
+      return 1;
+   }
+
+   if (config.duration < 0.0)
+   {
+      std::println("ERROR: duration must be non-negative");
+      return 1;
+   }
+
+   ClientConfig client_config;
+   try
+   {
+      client_config.request = make_request(config);
+   }
+   catch (const std::exception& ex)
+   {
+      std::println("ERROR: {}", ex.what());
+      return 1;
+   }
+   client_config.head = http::string_to_verb(config.method) == http::verb::head;
+   client_config.pipeline = config.pipeline;
+   auto duration = std::chrono::duration<double>(config.duration);
+   client_config.duration = duration_cast<steady_clock::duration>(duration);
+   config.threads = std::min(config.threads, config.connections);
+
+   //
+   // Run the configured number of connections, spread across the IO contexts.
+   //
+   std::vector<io_context> io_contexts(config.threads);
+   std::vector<Client> clients;
+   clients.reserve(config.connections);
+   auto futures = std::views::iota(size_t{0}, clients.capacity()) |
+                  std::views::transform([&](size_t i) mutable
+   {
+      auto executor = io_contexts[i % io_contexts.size()].get_executor();
+      clients.emplace_back(client_config);
+      return co_spawn(executor, clients.back().run(config.host, config.port), use_future);
+   }) | std::ranges::to<std::vector>();
+
+   auto t0 = steady_clock::now();
+   std::vector<std::jthread> threads;
+   for (auto& context : io_contexts)
+      threads.emplace_back([&context] { context.run(); });
+
+   size_t errors = 0;
+   for (auto& future : futures)
+   {
+      try
+      {
+         future.get();
+      }
+      catch (const std::exception& ex)
+      {
+         std::println("ERROR: {}", ex.what());
+         errors++;
+      }
+   }
+   auto dt = std::max(1ms, floor<milliseconds>(steady_clock::now() - t0));
+   threads.clear(); // join before the IO contexts are destroyed
+
+   Statistics total;
+   for (const auto& client : clients)
+      total.merge(client.statistics());
+
+   std::println("{} requests in {} over {} connection(s), pipeline depth {}: {:.0f} requests/s, "
+                "{} received ({:.1f} MiB/s)",
+                total.requests, dt, config.connections, config.pipeline,
+                total.requests * 1000.0 / dt.count(), Bytes(total.bytes),
+                double(total.bytes) / 1_m * 1000.0 / dt.count());
+   for (const auto& [status, histogram] : total.latency)
+      std::println("{} {}: {}", status, http::obsolete_reason(http::status(status)), histogram);
+
+   return errors ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+#!/usr/bin/env python3
+"""Run the echo servers across a matrix of client configurations and compare with a baseline.
+
+Unlike benchmark.sh, which draws bars, this collects the JSON records written by
+bin/client --json (or bin/corosio_client --json). Every server is started in turn on port 55555
+and measured for each combination of connection count and buffer size. The results are written
+to a JSON file, which can later be used as the baseline for another run:
+
+    echo/benchmark.py --output baseline.json
+    # ... upgrade ASIO, change compiler flags, ...
+    echo/benchmark.py --output results.json --baseline baseline.json --tolerance 0.1
+
+With a baseline, the exit status is 1 if the throughput of any configuration has dropped by more
+than the tolerance.
+"""
+
+from __future__ import annotations
+
+import argparse
+import json
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+from typing import Dict, List, Tuple
+
+Key = Tuple[str, int, int]  # (server, connections, buffer_size)
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser(
+        description="Benchmark the echo servers and compare against a stored baseline"
+    )
+    parser.add_argument(
+        "--build", default=Path("build"), type=Path, help="CMake build directory"
+    )
+    parser.add_argument(
+        "--client",
+        default="client",
+        choices=["client", "corosio_client"],
+        help="client binary from the bin directory of the build",
+    )
+    parser.add_argument(
+        "--servers",
+        nargs="+",
+        default=["echo_sync*", "echo_async*", "echo_coro*"],
+        help="glob patterns of the servers in the echo directory of the build",
+    )
+    parser.add_argument(
+        "--connections",
+        default="1,10,100",
+        type=int_list,
+        help="comma separated list of connection counts",
+    )
+    parser.add_argument(
+        "--buffer-sizes",
+        default="1024,65536",
+        type=int_list,
+        help="comma separated list of client buffer sizes, in bytes",
+    )
+    parser.add_argument(
+        "--duration", default=1.0, type=float, help="seconds per measurement"
+    )
+    parser.add_argument(
+        "--repeat",
+        default=1,
+        type=int,
+        help="number of measurements per configuration, the median throughput is kept",
+    )
+    parser.add_argument(
+        "--output",
+        default=Path("echo-benchmark.json"),
+        type=Path,
+        help="file to write the results to",
+    )
+    parser.add_argument(
+        "--baseline", type=Path, help="results of a previous run to compare against"
+    )
+    parser.add_argument(
+        "--tolerance",
+        default=0.1,
+        type=float,
+        help="relative throughput drop accepted before reporting a regression",
+    )
+    return parser.parse_args()
+
+
+def int_list(text: str) -> List[int]:
+    return [int(item) for item in text.split(",")]
+
+
+def find_servers(build: Path, patterns: List[str]) -> List[Path]:
+    servers = {
+        path
+        for pattern in patterns
+        for path in (build / "echo").glob(pattern)
+        if path.is_file() and path.stat().st_mode & 0o111
+    }
+    return sorted(servers)
+
+
+def measure(args: argparse.Namespace, connections: int, buffer_size: int) -> dict:
+    """Runs the client once against the server listening on the default port."""
+    with tempfile.NamedTemporaryFile(suffix=".json") as record:
+        command = [
+            str(args.build / "bin" / args.client),
+            f"--connections={connections}",
+            f"--buffer-size={buffer_size}",
+            f"--duration={args.duration}",
+            f"--json={record.name}",
+        ]
+        subprocess.run(command, check=True, stdout=subprocess.DEVNULL)
+        return json.loads(Path(record.name).read_text())
+
+
+def run_server(args: argparse.Namespace, server: Path) -> List[dict]:
+    results = []
+    process = subprocess.Popen(
+        [str(server)], stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL
+    )
+    try:
+        subprocess.run([str(args.build / "bin" / "wait_for_port")], check=True)
+        for connections in args.connections:
+            for buffer_size in args.buffer_sizes:
+                runs = [
+                    measure(args, connections, buffer_size) for _ in range(args.repeat)
+                ]
+                runs.sort(key=lambda run: run["throughput_mib_s"])
+                result = runs[len(runs) // 2]
+                result["server"] = server.name
+                result["samples_mib_s"] = [run["throughput_mib_s"] for run in runs]
+                results.append(result)
+                print(
+                    f"{server.name:32} c={connections:<5} b={buffer_size:<7} "
+                    f"{result['throughput_mib_s']:10.1f} MiB/s",
+                    flush=True,
+                )
+    finally:
+        process.kill()
+        process.wait()
+    return results
+
+
+def key(result: dict) -> Key:
+    config = result["config"]
+    return (result["server"], config["connections"], config["buffer_size"])
+
+
+def compare(results: List[dict], baseline: List[dict], tolerance: float) -> bool:
+    """Prints the change relative to the baseline and returns False on any regression."""
+    reference: Dict[Key, float] = {key(r): r["throughput_mib_s"] for r in baseline}
+    ok = True
+    print()
+    for result in results:
+        if key(result) not in reference:
+            continue
+        before = reference[key(result)]
+        after = result["throughput_mib_s"]
+        change = (after - before) / before if before > 0 else 0.0
+        regression = change < -tolerance
+        ok = ok and not regression
+        server, connections, buffer_size = key(result)
+        print(
+            f"{server:32} c={connections:<5} b={buffer_size:<7} "
+            f"{before:10.1f} -> {after:10.1f} MiB/s {change:+7.1%}"
+            f"{'  REGRESSION' if regression else ''}"
+        )
+
+    missing = set(reference) - {key(r) for r in results}
+    if missing:
+        print(f"\n{len(missing)} configurations of the baseline have not been measured")
+    return ok
+
+
+def main() -> int:
+    args = parse_args()
+    servers = find_servers(args.build, args.servers)
+    if not servers:
+        print(f"no servers found in {args.build / 'echo'}", file=sys.stderr)
+        return 1
+
+    results = []
+    for server in servers:
+        results += run_server(args, server)
+
+    args.output.write_text(json.dumps(results, indent=2) + "\n")
+    print(f"\nresults written to {args.output}")
+
+    if args.baseline:
+        baseline = json.loads(args.baseline.read_text())
+        if not compare(results, baseline, args.tolerance):
+            return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
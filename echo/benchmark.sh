@@ -14,6 +14,7 @@ wait
 lsof -t -iTCP:55555 -sTCP:LISTEN | xargs -r kill -9
 
 # collect echo implementations from 'echo' subdir, including 'go' and 'rust' ones
+# (this includes the '*_uring' variants, unless configured with -DECHO_IO_URING=OFF)
 shopt -s nullglob
 P=$(dirname "$0")/..
 SERVERS=("$P"/build/echo/echo_{sync,async,coro}*) 
@@ -32,6 +33,7 @@ do
    [[ ${ECHO} = *_sync*  ]] && echo -ne "\x1b[1;31m"
    [[ ${ECHO} = *_async* ]] && echo -ne "\x1b[1;33m"
    [[ ${ECHO} = *_coro*  ]] && echo -ne "\x1b[1;32m"
+   [[ ${ECHO} = *_uring* ]] && echo -ne "\x1b[1;36m"
    [[ ${ECHO} = *-go*    ]] && echo -ne "\x1b[1;34m"
    [[ ${ECHO} = *-rust*  ]] && echo -ne "\x1b[38;5;166m"
    for ((i = 0; i < N*WIDTH/MAX; i++)); do echo -n '▆'; done
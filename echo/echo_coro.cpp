@@ -1,3 +1,5 @@
+#include "recycled_buffer.hpp"
+
 #include <boost/asio.hpp>
 
 using namespace boost::asio;
@@ -5,11 +7,11 @@ using ip::tcp;
 
 awaitable<void> session(tcp::socket socket)
 {
-   std::array<char, 64 * 1024> data;
+   RecycledBuffer<64 * 1024> data; // keeps the coroutine frame small enough for recycling
    for (;;)
    {
-      size_t n = co_await socket.async_read_some(buffer(data));
-      co_await async_write(socket, buffer(data, n));
+      size_t n = co_await socket.async_read_some(buffer(data.data(), data.size()));
+      co_await async_write(socket, buffer(data.data(), n));
    }
 }
 
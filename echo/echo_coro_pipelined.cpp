@@ -0,0 +1,30 @@
+/**
+ * Echo server overlapping reads and writes, see pipelined_relay() in stream_utils.hpp.
+ *
+ * While an echo is still being written, the next read is already in flight. Buffers that have
+ * been filled in the meantime are written back together, using a single vectored write.
+ */
+#include "stream_utils.hpp"
+
+#include <boost/asio.hpp>
+
+using namespace boost::asio;
+using ip::tcp;
+
+awaitable<void> session(tcp::socket socket)
+{
+   co_await pipelined_relay(socket, socket);
+}
+
+awaitable<void> server(tcp::acceptor a)
+{
+   for (;;)
+      co_spawn(a.get_executor(), session(co_await a.async_accept()), detached);
+}
+
+int main()
+{
+   io_context context;
+   co_spawn(context, server({context, {tcp::v6(), 55555}}), detached);
+   context.run();
+}
@@ -0,0 +1,53 @@
+/**
+ * Echo server taking its buffers from a per-IO context pool, and only while data is moving.
+ *
+ * Each session waits for its socket to become readable before acquiring a buffer, and returns it
+ * after the echo has been written. Idle connections don't hold a buffer at all, so 10k mostly idle
+ * connections only need as many buffers as there are connections with data in flight.
+ *
+ * The io_uring variant, echo_coro_pooled_uring, creates the pool with buffers registered with the
+ * kernel. Reading into and writing from those uses IORING_OP_READ_FIXED and WRITE_FIXED, which
+ * skip mapping the user pages for each operation.
+ */
+#include "buffer_pool.hpp"
+
+#include <boost/asio.hpp>
+
+using namespace boost::asio;
+using ip::tcp;
+
+awaitable<void> session(tcp::socket socket)
+{
+   auto& pool = BufferPool::of(socket.get_executor());
+   for (;;)
+   {
+      co_await socket.async_wait(tcp::socket::wait_read);
+      auto data = pool.acquire();
+#if defined(BOOST_ASIO_HAS_IO_URING)
+      if (auto registered = data.registered())
+      {
+         size_t n = co_await socket.async_read_some(*registered);
+         co_await async_write(socket, buffer(*registered, n));
+         continue;
+      }
+#endif
+      size_t n = co_await socket.async_read_some(data.buffer());
+      co_await async_write(socket, data.buffer(n));
+   }
+}
+
+awaitable<void> server(tcp::acceptor a)
+{
+   for (;;)
+      co_spawn(a.get_executor(), session(co_await a.async_accept()), detached);
+}
+
+int main()
+{
+   io_context context;
+#if defined(BOOST_ASIO_HAS_IO_URING)
+   make_service<BufferPool>(context, BufferPool::Registered{BufferPool::max_cached});
+#endif
+   co_spawn(context, server({context, {tcp::v6(), 55555}}), detached);
+   context.run();
+}
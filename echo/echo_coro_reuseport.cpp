@@ -0,0 +1,109 @@
+/**
+ * Echo server with one IO context per thread, each with its own acceptor listening on the same
+ * port with SO_REUSEPORT. The kernel distributes incoming connections across the acceptors, so
+ * there is neither a single accept loop nor a handoff of sockets between threads.
+ *
+ * There is one thread per available CPU. With --pin, each thread is pinned to its CPU before it
+ * creates its IO context. With the kernel's first-touch policy, the context and the sessions'
+ * memory then stay on that CPU's NUMA node. --cpus selects the CPUs, like '0-3,8'.
+ */
+#include "affinity.hpp"
+#include "recycled_buffer.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/program_options.hpp>
+
+#include <sys/socket.h>
+
+#include <iostream>
+#include <print>
+#include <thread>
+
+using namespace boost::asio;
+using ip::tcp;
+
+awaitable<void> session(tcp::socket socket)
+{
+   RecycledBuffer<64 * 1024> data; // keeps the coroutine frame small enough for recycling
+   for (;;)
+   {
+      size_t n = co_await socket.async_read_some(buffer(data.data(), data.size()));
+      co_await async_write(socket, buffer(data.data(), n));
+   }
+}
+
+awaitable<void> server(tcp::acceptor a)
+{
+   for (;;)
+      co_spawn(a.get_executor(), session(co_await a.async_accept()), detached);
+}
+
+/// Sets SO_REUSEPORT, for which Asio has no public socket option.
+void set_reuse_port(tcp::acceptor& acceptor)
+{
+   int one = 1;
+   if (::setsockopt(acceptor.native_handle(), SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0)
+      throw boost::system::system_error(errno, boost::system::system_category(), "SO_REUSEPORT");
+}
+
+tcp::acceptor make_acceptor(io_context& context, const tcp::endpoint& endpoint)
+{
+   tcp::acceptor acceptor(context, endpoint.protocol());
+   acceptor.set_option(tcp::acceptor::reuse_address(true));
+   set_reuse_port(acceptor);
+   acceptor.bind(endpoint);
+   acceptor.listen();
+   return acceptor;
+}
+
+int main(int argc, char* argv[])
+{
+   namespace po = boost::program_options;
+   bool pin = false;
+   std::string cpu_list;
+
+   po::options_description desc("Usage");
+   desc.add_options() //
+      ("help,h", "produce help message") //
+      ("pin", po::bool_switch(&pin), "pin each thread to its CPU") //
+      ("cpus", po::value(&cpu_list)->value_name("LIST"),
+       "run threads on the CPUs in LIST only, like '0-3,8' (implies --pin)");
+
+   std::vector<unsigned> cpus;
+   try
+   {
+      po::variables_map vm;
+      po::store(po::parse_command_line(argc, argv, desc), vm);
+      po::notify(vm);
+      if (vm.count("help"))
+      {
+         desc.print(std::cout);
+         return 0;
+      }
+
+      if (!cpu_list.empty())
+      {
+         cpus = parse_cpu_list(cpu_list);
+         check_cpus_available(cpus);
+         pin = true;
+      }
+      else
+         cpus = available_cpus();
+   }
+   catch (const std::exception& ex)
+   {
+      std::println(std::cerr, "ERROR: {}", ex.what());
+      return 1;
+   }
+
+   std::vector<std::jthread> threads;
+   for (auto cpu : cpus)
+      threads.emplace_back([cpu, pin]()
+      {
+         if (pin)
+            pin_this_thread(cpu);
+         io_context context(1); // concurrency hint: run by this thread only, no locking needed
+         co_spawn(context, server(make_acceptor(context, {tcp::v6(), 55555})), detached);
+         context.run();
+      });
+}
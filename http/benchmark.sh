@@ -0,0 +1,43 @@
+#!/usr/bin/bash -e
+#
+# Script for comparing the JSON pretty-printers (rapidjson, jsoncons and simdjson) using 'h2load'
+# from nghttp2 in HTTP/1.1 mode. Every server is sent the same document many times over a number
+# of keep-alive connections. Uses localhost port 55555, like the servers themselves.
+#
+#   http/benchmark.sh [DOCUMENT] [h2load options...]
+#
+# TARGET=/stream measures the chunked streaming mode, where the servers support it.
+#
+P=$(dirname "$0")/..
+DOCUMENT=${1:-$P/test/data/64KB-min.json}
+shift || true
+H2LOAD=(h2load --h1 --requests=${REQUESTS:-20000} --clients=${CLIENTS:-8} --threads=${THREADS:-4}
+        --data="$DOCUMENT" "$@" http://localhost:55555${TARGET:-/})
+
+cmake --build "$P/build"
+
+# kill any leftover processes
+lsof -t -iTCP:55555 -sTCP:LISTEN | xargs -r kill -9
+
+SERVERS=("$P"/build/http/{rapidjson,jsoncons,simdjson}_pretty)
+
+WIDTH=80
+MAX=${MAX:-20000}
+PATTERN='finished in [^,]+, ([0-9]+)\.[0-9]+ req/s, ([0-9.]+[KMG]?B)/s'
+for SERVER in "${SERVERS[@]}"
+do
+   # the simdjson variant is built only if simdjson is installed
+   [[ -x $SERVER ]] || continue
+   "$SERVER" >/dev/null 2>&1 &
+   "$P/build/bin/wait_for_port"
+   OUTPUT=$("${H2LOAD[@]}")
+   [[ $OUTPUT =~ ([0-9]+)\ succeeded ]] && SUCCEEDED=${BASH_REMATCH[1]}
+   [[ $OUTPUT =~ $PATTERN ]] || { echo "$OUTPUT"; exit 1; }
+   N=${BASH_REMATCH[1]}
+   printf '%6d req/s %10s/s ' $N ${BASH_REMATCH[2]}
+   for ((i = 0; i < N*WIDTH/MAX && i < WIDTH; i++)); do echo -n '▆'; done
+   for ((; i < WIDTH; i++)); do echo -n '·'; done
+   echo " ${SERVER##*/} ($SUCCEEDED succeeded)"
+   kill $!
+   wait || true
+done
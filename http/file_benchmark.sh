@@ -0,0 +1,41 @@
+#!/usr/bin/bash -e
+#
+# Script for comparing the file server's sendfile() path with copying through a user space buffer
+# (--copy). A random file of SIZE bytes is downloaded over and over again with bin/http_client.
+# Besides the throughput, the CPU time spent by the server is reported. Uses localhost port 55555.
+#
+#   http/file_benchmark.sh [SIZE] [http_client options...]
+#
+P=$(dirname "$0")/..
+SIZE=${1:-64M}
+shift || true
+CLIENT=("$P/build/bin/http_client" --target /file --connections=${CONNECTIONS:-4}
+        --duration=${DURATION:-5} "$@")
+
+cmake --build "$P/build"
+
+# kill any leftover processes
+lsof -t -iTCP:55555 -sTCP:LISTEN | xargs -r kill -9
+
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+head -c "$SIZE" /dev/urandom >"$DIR/file"
+
+TICKS=$(getconf CLK_TCK)
+for MODE in sendfile copy
+do
+   OPTIONS=(--root "$DIR")
+   [[ $MODE == copy ]] && OPTIONS+=(--copy)
+   "$P/build/http/file_server" "${OPTIONS[@]}" >/dev/null 2>&1 &
+   SERVER=$!
+   "$P/build/bin/wait_for_port"
+   OUTPUT=$("${CLIENT[@]}")
+
+   # utime and stime of the server, in clock ticks
+   read -r UTIME STIME < <(cut -d' ' -f14,15 /proc/$SERVER/stat)
+   printf '%-8s %s\n' $MODE "${OUTPUT%%$'\n'*}"
+   awk -v u=$UTIME -v s=$STIME -v t=$TICKS \
+       'BEGIN { printf "         server CPU time: %.2fs user, %.2fs system\n", u / t, s / t }'
+   kill $SERVER
+   wait || true
+done
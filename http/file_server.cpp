@@ -0,0 +1,285 @@
+/**
+ * HTTP/1.1 server serving the files of a directory, with support for single range requests.
+ *
+ * The body of a file is sent with sendfile(2): The kernel copies it from the page cache into the
+ * socket without passing it through user space. With --copy, each block of the file is read into
+ * a buffer and then written to the socket instead, which is what Beast's \c file_body does, too.
+ * Compare the two with http/file_benchmark.sh.
+ *
+ * http/file_server --root test/data
+ * curl http://localhost:55555/64KB-min.json -r 0-99
+ *
+ * Files outside of the root directory are rejected with 403, also when reached by a symbolic link:
+ *
+ * curl --path-as-is http://localhost:55555//etc/passwd
+ *
+ * The socket is non-blocking: If it is full, sendfile() returns early and the coroutine waits
+ * until the socket is writable again. Like reading a file with pread(), sendfile() blocks on disk
+ * I/O if the file is not in the page cache.
+ */
+#include "literals.hpp"
+#include "program_options.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+#include <boost/program_options.hpp>
+
+#include <sys/sendfile.h>
+
+#include <array>
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <optional>
+
+using namespace boost::asio;
+using namespace boost::beast;
+using ip::tcp;
+
+struct Config
+{
+   std::string root = ".";
+   bool copy = false;
+};
+
+// =================================================================================================
+
+/// The part of a file to be sent, as selected by the Range header of a request.
+struct ByteRange
+{
+   uint64_t offset = 0;
+   uint64_t length = 0;
+   bool partial = false; // respond with 206 Partial Content
+   bool satisfiable = true; // respond with 416 Range Not Satisfiable otherwise
+};
+
+/// Parses a decimal number, the whole of \p text.
+std::optional<uint64_t> parse_number(std::string_view text)
+{
+   uint64_t value;
+   auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+   if (text.empty() || ec != std::errc() || end != text.data() + text.size())
+      return std::nullopt;
+   return value;
+}
+
+/**
+ * Parses the value of a Range header for a file of \p size bytes. Only a single range of bytes
+ * is supported: If \p header is missing, malformed, or lists multiple ranges, it is ignored and
+ * the whole file is selected, as permitted by RFC 9110.
+ */
+ByteRange parse_range(std::string_view header, uint64_t size)
+{
+   const ByteRange whole{0, size};
+   if (!header.starts_with("bytes="))
+      return whole;
+
+   auto spec = header.substr(6);
+   auto dash = spec.find('-');
+   if (dash == std::string_view::npos || spec.find(',') != std::string_view::npos)
+      return whole;
+
+   auto first = parse_number(spec.substr(0, dash));
+   auto last = parse_number(spec.substr(dash + 1));
+   if (!first) // suffix range: the last N bytes
+   {
+      if (!last || dash != 0)
+         return whole;
+      if (*last == 0 || size == 0)
+         return {.satisfiable = false};
+      auto length = std::min(*last, size);
+      return {size - length, length, true};
+   }
+
+   if (dash + 1 < spec.size() && (!last || *last < *first))
+      return whole;
+   if (*first >= size)
+      return {.satisfiable = false};
+   auto end = last ? std::min(*last, size - 1) + 1 : size;
+   return {*first, end - *first, true};
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/// Sends \p length bytes of the file \p fd, starting at \p offset, with sendfile(2).
+awaitable<void> send_file(tcp::socket& socket, int fd, off_t offset, uint64_t length)
+{
+   while (length)
+   {
+      auto n = ::sendfile(socket.native_handle(), fd, &offset, std::min<uint64_t>(length, 1_g));
+      if (n > 0)
+         length -= n;
+      else if (n == 0)
+         throw system_error(boost::asio::error::eof); // file truncated meanwhile
+      else if (errno == EAGAIN)
+         co_await socket.async_wait(tcp::socket::wait_write);
+      else if (errno != EINTR)
+         throw system_error(error_code(errno, boost::system::system_category()));
+   }
+}
+
+/// Sends \p length bytes of the file \p fd, starting at \p offset, through a user space buffer.
+awaitable<void> copy_file(tcp::socket& socket, int fd, off_t offset, uint64_t length)
+{
+   std::array<char, 64_k> data;
+   while (length)
+   {
+      auto n = ::pread(fd, data.data(), std::min<uint64_t>(length, data.size()), offset);
+      if (n > 0)
+      {
+         co_await async_write(socket, buffer(data, n));
+         offset += n;
+         length -= n;
+      }
+      else if (n == 0)
+         throw system_error(boost::asio::error::eof); // file truncated meanwhile
+      else if (errno != EINTR)
+         throw system_error(error_code(errno, boost::system::system_category()));
+   }
+}
+
+std::string_view mime_type(const std::filesystem::path& path)
+{
+   auto extension = path.extension();
+   if (extension == ".html" || extension == ".htm")
+      return "text/html";
+   if (extension == ".txt" || extension == ".md")
+      return "text/plain";
+   if (extension == ".json")
+      return "application/json";
+   if (extension == ".css")
+      return "text/css";
+   if (extension == ".js")
+      return "text/javascript";
+   if (extension == ".png")
+      return "image/png";
+   if (extension == ".jpg" || extension == ".jpeg")
+      return "image/jpeg";
+   if (extension == ".svg")
+      return "image/svg+xml";
+   return "application/octet-stream";
+}
+
+// -------------------------------------------------------------------------------------------------
+
+using Request = http::request<http::string_body>;
+
+awaitable<void> respond(tcp::socket& socket, const Request& request, http::status status,
+                        std::string body)
+{
+   http::response<http::string_body> response{status, request.version()};
+   response.set(http::field::content_type, "text/plain");
+   if (status == http::status::method_not_allowed)
+      response.set(http::field::allow, "GET, HEAD");
+   response.keep_alive(request.keep_alive());
+   response.body() = std::move(body) + '\n';
+   response.prepare_payload();
+   co_await http::async_write(socket, response);
+}
+
+awaitable<void> serve(tcp::socket& socket, const Request& request, const Config& config)
+{
+   if (request.method() != http::verb::get && request.method() != http::verb::head)
+      co_return co_await respond(socket, request, http::status::method_not_allowed,
+                                 "only GET and HEAD are supported");
+
+   auto target = std::string_view(request.target());
+   target = target.substr(0, target.find('?'));
+   if (!target.starts_with('/') || target.find("..") != std::string_view::npos)
+      co_return co_await respond(socket, request, http::status::bad_request,
+                                 std::format("invalid target {}", target));
+
+   //
+   // Resolve symbolic links and make sure that the file is inside of the root directory. The
+   // relative path drops all leading slashes, which would replace the root when appended.
+   //
+   std::error_code fs_ec;
+   auto root = std::filesystem::weakly_canonical(config.root, fs_ec);
+   auto path = root / std::filesystem::path(target).relative_path();
+   if (target.ends_with('/'))
+      path /= "index.html";
+   path = std::filesystem::weakly_canonical(path, fs_ec);
+   if (fs_ec || std::ranges::mismatch(root, path).in1 != root.end())
+      co_return co_await respond(socket, request, http::status::forbidden,
+                                 std::format("{} is outside of the root directory", target));
+
+   error_code ec;
+   file_posix file;
+   if (std::filesystem::is_regular_file(path, fs_ec))
+      file.open(path.c_str(), file_mode::scan, ec);
+   auto size = file.is_open() ? file.size(ec) : 0;
+   if (!file.is_open() || ec)
+      co_return co_await respond(socket, request, http::status::not_found,
+                                 std::format("{} not found", target));
+
+   auto range = parse_range(request[http::field::range], size);
+   if (!range.satisfiable)
+   {
+      http::response<http::empty_body> response{http::status::range_not_satisfiable,
+                                                request.version()};
+      response.set(http::field::content_range, std::format("bytes */{}", size));
+      response.keep_alive(request.keep_alive());
+      response.content_length(0);
+      co_await http::async_write(socket, response);
+      co_return;
+   }
+
+   //
+   // Write the header with Beast, then the body without a serializer.
+   //
+   http::response<http::empty_body> response{
+      range.partial ? http::status::partial_content : http::status::ok, request.version()};
+   response.set(http::field::content_type, mime_type(path));
+   response.set(http::field::accept_ranges, "bytes");
+   if (range.partial)
+      response.set(http::field::content_range,
+                   std::format("bytes {}-{}/{}", range.offset,
+                               range.offset + range.length - 1, size));
+   response.keep_alive(request.keep_alive());
+   response.content_length(range.length);
+   http::response_serializer<http::empty_body> serializer{response};
+   co_await http::async_write_header(socket, serializer);
+
+   if (request.method() == http::verb::head)
+      co_return;
+   if (config.copy)
+      co_await copy_file(socket, file.native_handle(), range.offset, range.length);
+   else
+      co_await send_file(socket, file.native_handle(), range.offset, range.length);
+}
+
+awaitable<void> session(tcp::socket socket, const Config& config)
+{
+   socket.native_non_blocking(true); // for sendfile()
+   flat_buffer buffer;
+   for (bool keep_alive = true; keep_alive;)
+   {
+      Request request;
+      co_await http::async_read(socket, buffer, request);
+      keep_alive = request.keep_alive();
+      co_await serve(socket, request, config);
+   }
+   socket.shutdown(tcp::socket::shutdown_send);
+}
+
+awaitable<void> server(tcp::acceptor a, const Config& config)
+{
+   for (;;)
+      co_spawn(a.get_executor(), session(co_await a.async_accept(), config), detached);
+}
+
+int main(int argc, char* argv[])
+{
+   Config config;
+   namespace po = boost::program_options;
+   po::options_description options("File server");
+   options.add_options() //
+      ("root", po::value(&config.root)->default_value(config.root)->value_name("DIR"),
+       "directory to serve files from") //
+      ("copy", po::bool_switch(&config.copy),
+       "copy files through a user space buffer instead of using sendfile()");
+
+   io_context context;
+   co_spawn(context, server({context, {tcp::v6(), 55555}}, config), detached);
+   return run(context, argc, argv, options);
+}
@@ -3,7 +3,22 @@
  * On invalid input, a detailed error message is put into the response instead.
  *
  * Shows how to use Boost.Beast for asynchronously reading/writing a HTTP request/response pair.
+ *
+ * Allocations per request are avoided as far as possible: The request and response bodies are
+ * reused across keep-alive requests, keeping their capacity. The header fields and the parsed
+ * document are allocated from a per-connection arena (\c jsoncons::pmr::json), which is reset
+ * after each request.
+ *
+ * The arena's initial buffer of 64 KiB is part of the coroutine frame. So each connection takes
+ * that much heap, even while idle, and frames that large are not recycled by ASIO. For larger
+ * documents, the arena allocates more memory, which is released after each request again.
+ *
+ * Requests to /stream are answered with chunked transfer encoding instead, sending the output
+ * while it is being produced:
+ *
+ * curl http://localhost:55555/stream -d @test/data/64KB-min.json
  */
+#include "literals.hpp"
 #include "program_options.hpp"
 
 #include <boost/asio.hpp>
@@ -11,37 +26,140 @@
 
 #include <jsoncons/json.hpp>
 
+#include <array>
+#include <memory_resource>
+
 using namespace boost::asio;
 using namespace boost::beast;
 using namespace jsoncons;
 using ip::tcp;
 
-awaitable<void> session(tcp::socket socket)
+using Allocator = std::pmr::polymorphic_allocator<char>;
+using Fields = http::basic_fields<Allocator>;
+using Request = http::request<http::string_body, Fields>;
+
+/**
+ * Writes the body of \p request pretty-printed as a chunked response, using \p out as the buffer
+ * for each chunk. The body is passed to the parser in slices, which is connected directly to the
+ * encoder without building a document in between. After each slice, a complete chunk is written
+ * with backpressure like in http/echo.cpp.
+ *
+ * A syntax error is thrown as is if nothing has been sent yet, so the caller can respond with an
+ * error instead. Later, the header has already promised success, so the connection is aborted
+ * without the final chunk.
+ */
+awaitable<void> write_chunked(tcp::socket& socket, const Request& request, std::string& out)
 {
-   flat_buffer buffer;
-   for (;;)
-   {
-      http::request<http::string_body> request;
-      co_await http::async_read(socket, buffer, request);
+   http::response<http::buffer_body, Fields> response(
+      std::piecewise_construct, std::make_tuple(), std::make_tuple(request.get_allocator()));
+   response.result(http::status::ok);
+   response.version(request.version());
+   response.set(http::field::content_type, "application/json");
+   response.chunked(true);
+   http::response_serializer<http::buffer_body, Fields> serializer{response};
+   serializer.limit(0);
 
-      http::response<http::string_body> response;
+   json_parser parser;
+   json_string_encoder encoder(out);
+   std::string_view input = request.body();
+   for (bool complete = false; !complete;)
+   {
       try
       {
-         auto j = json::parse(request.body());
-         response.result(http::status::ok);
-         response.set(http::field::content_type, "application/json");
-         encode_json_pretty(j, response.body());
+         auto n = std::min<size_t>(input.size(), 16_k);
+         parser.update(input.data(), n);
+         input.remove_prefix(n);
+         if (!parser.done())
+            parser.parse_some(encoder);
+         if (parser.done())
+            parser.check_done(); // no trailing content in this slice, like json_reader does
+         if (input.empty())
+         {
+            parser.finish_parse(encoder);
+            parser.check_done();
+            encoder.flush();
+            out += '\n';
+            complete = true;
+         }
       }
-      catch (json_exception& ex)
+      catch (json_exception&)
       {
-         response.result(http::status::bad_request);
-         response.set(http::field::content_type, "text/plain");
-         response.body() = ex.what();
+         if (serializer.is_header_done())
+            throw std::runtime_error("invalid JSON after the response has been started");
+         throw;
+      }
+      if (!complete && out.size() < 16_k)
+         continue;
+
+      if (!serializer.is_header_done())
+         co_await http::async_write_header(socket, serializer);
+
+      response.body().data = out.data();
+      response.body().size = out.size();
+      response.body().more = !complete;
+      auto [ec, n] = co_await http::async_write(socket, serializer, as_tuple);
+      if (ec && ec != http::error::need_buffer)
+         throw system_error(ec);
+      out.clear();
+   }
+}
+
+awaitable<void> session(tcp::socket socket)
+{
+   std::array<std::byte, 64_k> arena_buffer;
+   std::pmr::monotonic_buffer_resource arena(arena_buffer.data(), arena_buffer.size());
+
+   std::string request_body, response_body;
+   flat_buffer buffer;
+   for (;;)
+   {
+      {
+         http::request_parser<http::string_body, Allocator> parser(
+            std::piecewise_construct, std::make_tuple(std::move(request_body)),
+            std::make_tuple(Allocator(&arena)));
+         co_await http::async_read(socket, buffer, parser);
+         auto& request = parser.get();
+
+         http::response<http::string_body, Fields> response(
+            std::piecewise_construct, std::make_tuple(std::move(response_body)),
+            std::make_tuple(Allocator(&arena)));
+         //
+         // Streaming is only possible with HTTP/1.1, HTTP/1.0 doesn't know chunked encoding.
+         //
+         bool chunked = request.target() == "/stream" && request.version() >= 11;
+         bool failed = false;
+         try
+         {
+            if (chunked)
+               co_await write_chunked(socket, request, response.body());
+            else
+            {
+               auto j = pmr::json::parse(combine_allocators(Allocator(&arena)), request.body());
+               response.result(http::status::ok);
+               response.set(http::field::content_type, "application/json");
+               encode_json_pretty(j, response.body());
+            }
+         }
+         catch (json_exception& ex)
+         {
+            response.result(http::status::bad_request);
+            response.set(http::field::content_type, "text/plain");
+            response.body() = ex.what();
+            failed = true;
+         }
+         if (!chunked || failed)
+         {
+            response.body() += '\n';
+            response.prepare_payload();
+            co_await http::async_write(socket, response);
+         }
+         request_body = std::move(request.body());
+         response_body = std::move(response.body());
       }
-      response.body() += '\n';
-      response.prepare_payload();
 
-      co_await http::async_write(socket, response);
+      request_body.clear();
+      response_body.clear();
+      arena.release();
    }
 }
 
@@ -0,0 +1,210 @@
+/**
+ * HTTP/1.1 server accepting JSON documents and returning them pretty-printed.
+ * On invalid input, a detailed error message is put into the response instead.
+ *
+ * Same as rapidjson_pretty.cpp and jsoncons_pretty.cpp, but using the SIMD accelerated 'simdjson'
+ * parser. Its "On-Demand" API doesn't build a DOM at all: The document is tokenized in a single
+ * SIMD pass and then walked directly, writing the output straight into the body of the response.
+ *
+ * Scalars are not converted and formatted again, but copied verbatim from the input, including
+ * the escape sequences of strings. They are still parsed to validate them, though. simdjson
+ * requires some padding after the input, which is reserved in the request body before reading it.
+ *
+ * Compare the three implementations with http/benchmark.sh.
+ */
+#include "program_options.hpp"
+
+#include <boost/asio.hpp>
+#include <boost/beast.hpp>
+
+#include <simdjson.h>
+
+using namespace boost::asio;
+using namespace boost::beast;
+using ip::tcp;
+
+// =================================================================================================
+
+/**
+ * Appends a pretty-printed version of an On-Demand document to a string, formatted like
+ * rapidjson's PrettyWriter: four spaces of indentation and a space after the colon.
+ */
+class PrettyPrinter
+{
+public:
+   explicit PrettyPrinter(std::string& out) : out_(out) {}
+
+   void document(simdjson::ondemand::document& doc)
+   {
+      if (doc.is_scalar())
+      {
+         scalar(doc.raw_json_token());
+         validate(doc); // getting the raw token neither validates nor consumes it
+      }
+      else
+      {
+         simdjson::ondemand::value root = doc.get_value();
+         value(root);
+      }
+
+      if (!doc.at_end())
+         throw simdjson::simdjson_error(simdjson::TRAILING_CONTENT);
+   }
+
+private:
+   void value(simdjson::ondemand::value& value)
+   {
+      switch (value.type())
+      {
+      case simdjson::ondemand::json_type::object:
+         object(value.get_object());
+         break;
+      case simdjson::ondemand::json_type::array:
+         array(value.get_array());
+         break;
+      default:
+         scalar(value.raw_json_token());
+         validate(value);
+         break;
+      }
+   }
+
+   void object(simdjson::ondemand::object object)
+   {
+      out_ += '{';
+      ++depth_;
+      bool first = true;
+      for (auto field : object)
+      {
+         separator(first);
+         out_ += '"';
+         out_ += field.escaped_key().value();
+         field.unescaped_key().value(); // validates the escape sequences
+         out_ += "\": ";
+         simdjson::ondemand::value v = field.value();
+         value(v);
+      }
+      close(first, '}');
+   }
+
+   void array(simdjson::ondemand::array array)
+   {
+      out_ += '[';
+      ++depth_;
+      bool first = true;
+      for (simdjson::ondemand::value element : array)
+      {
+         separator(first);
+         value(element);
+      }
+      close(first, ']');
+   }
+
+   /// Parses a scalar document or value, throwing if it is malformed.
+   template <typename Scalar>
+   static void validate(Scalar& scalar)
+   {
+      switch (scalar.type())
+      {
+      case simdjson::ondemand::json_type::number:
+         if (auto number = scalar.get_number(); number.error() == simdjson::BIGINT_ERROR)
+            scalar.get_double().value(); // valid JSON, but too large for 64 bit integers
+         else
+            number.value();
+         break;
+      case simdjson::ondemand::json_type::string:
+         scalar.get_string().value();
+         break;
+      case simdjson::ondemand::json_type::boolean:
+         scalar.get_bool().value();
+         break;
+      default:
+         if (!scalar.is_null())
+            throw simdjson::simdjson_error(simdjson::N_ATOM_ERROR);
+         break;
+      }
+   }
+
+   /// The raw token includes any whitespace up to the next token.
+   void scalar(std::string_view token)
+   {
+      out_ += token.substr(0, token.find_last_not_of(" \t\n\r") + 1);
+   }
+
+   void separator(bool& first)
+   {
+      if (!first)
+         out_ += ',';
+      first = false;
+      newline();
+   }
+
+   void close(bool empty, char bracket)
+   {
+      --depth_;
+      if (!empty)
+         newline();
+      out_ += bracket;
+   }
+
+   void newline()
+   {
+      out_ += '\n';
+      out_.append(depth_ * 4, ' ');
+   }
+
+   std::string& out_;
+   size_t depth_ = 0;
+};
+
+// -------------------------------------------------------------------------------------------------
+
+awaitable<void> session(tcp::socket socket)
+{
+   simdjson::ondemand::parser parser; // reuses its internal buffers for all documents
+   flat_buffer buffer;
+   for (;;)
+   {
+      http::request_parser<http::string_body> request_parser;
+      co_await http::async_read_header(socket, buffer, request_parser);
+      if (auto length = request_parser.content_length())
+         request_parser.get().body().reserve(*length + simdjson::SIMDJSON_PADDING);
+      co_await http::async_read(socket, buffer, request_parser);
+      auto& body = request_parser.get().body();
+      body.reserve(body.size() + simdjson::SIMDJSON_PADDING); // no-op unless chunked
+
+      http::response<http::string_body> response;
+      try
+      {
+         response.body().reserve(body.size() * 2);
+         simdjson::padded_string_view json(body.data(), body.size(), body.capacity());
+         auto doc = parser.iterate(json).value();
+         PrettyPrinter(response.body()).document(doc);
+         response.result(http::status::ok);
+         response.set(http::field::content_type, "application/json");
+      }
+      catch (simdjson::simdjson_error& ex)
+      {
+         response.result(http::status::bad_request);
+         response.set(http::field::content_type, "text/plain");
+         response.body() = ex.what();
+      }
+      response.body() += '\n';
+      response.prepare_payload();
+
+      co_await http::async_write(socket, response);
+   }
+}
+
+awaitable<void> server(tcp::acceptor a)
+{
+   for (;;)
+      co_spawn(a.get_executor(), session(co_await a.async_accept()), detached);
+}
+
+int main(int argc, char* argv[])
+{
+   io_context context;
+   co_spawn(context, server({context, {tcp::v6(), 55555}}), detached);
+   return run(context, argc, argv);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string_view>
+#include <vector>
+
+// =================================================================================================
+
+/**
+ * Parses a CPU list in the format used by Linux (see cpuset(7)), like "0-3,8,10-11".
+ * Throws \c std::invalid_argument if \p list is malformed.
+ */
+std::vector<unsigned> parse_cpu_list(std::string_view list);
+
+/// Returns the CPUs the calling thread is allowed to run on, in ascending order.
+std::vector<unsigned> available_cpus();
+
+/**
+ * Throws \c std::invalid_argument if any of \p cpus is not available to the calling thread, like
+ * a CPU that is offline or outside of its cpuset. Pinning a thread to it would fail.
+ */
+void check_cpus_available(const std::vector<unsigned>& cpus);
+
+/// Returns the NUMA node of the given \p cpu, or -1 if unknown.
+int numa_node(unsigned cpu);
+
+/**
+ * Pins the calling thread to a single \p cpu. Throws \c boost::system::system_error on failure.
+ *
+ * Memory is allocated on the NUMA node of the CPU that first touches it. So for keeping an
+ * \c io_context and its buffers local to a node, pin the thread first and create them afterwards.
+ */
+void pin_this_thread(unsigned cpu);
+
+// =================================================================================================
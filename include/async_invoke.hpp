@@ -3,10 +3,26 @@
 #include <boost/asio/associated_cancellation_slot.hpp>
 #include <boost/asio/associated_executor.hpp>
 #include <boost/asio/async_result.hpp>
+#include <boost/asio/bind_allocator.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/executor_work_guard.hpp>
 #include <boost/asio/post.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <stop_token>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <variant>
+#include <vector>
 
 namespace asio = boost::asio;
 
@@ -76,6 +92,327 @@ auto async_invoke(Executor& executor, F&& f, Args&&... args)
                        std::forward<Args>(args)...);
 }
 
+// -------------------------------------------------------------------------------------------------
+
+namespace asio_coro_detail
+{
+/**
+ * Shared state of \c async_invoke_bulk(). The chunk that finishes last completes the operation.
+ *
+ * The state is allocated with \c std::allocator rather than the handler's allocator: Chunks that
+ * are not last still own a reference after decrementing \c remaining, which may be after the
+ * upcall.
+ */
+template <typename Handler, typename Executor, typename Input, typename F, typename R>
+struct BulkInvoke
+{
+   BulkInvoke(Handler handler, Executor executor, std::vector<Input> inputs, F f, size_t chunks)
+      : handler(std::move(handler)), work(std::move(executor)), inputs(std::move(inputs)),
+        f(std::move(f)), results(this->inputs.size()), remaining(chunks)
+   {
+   }
+
+   void run(std::shared_ptr<BulkInvoke> self, size_t begin, size_t end)
+   {
+      for (size_t i = begin; i < end && !failed.load(std::memory_order_relaxed); ++i)
+      {
+         try
+         {
+            if (cancelled.load(std::memory_order_relaxed))
+               throw boost::system::system_error(asio::error::operation_aborted);
+            results[i].emplace(std::invoke(f, inputs[i]));
+         }
+         catch (...)
+         {
+            if (!failed.exchange(true, std::memory_order_relaxed))
+               error = std::current_exception();
+         }
+      }
+
+      if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+         complete(std::move(self));
+   }
+
+   static void complete(std::shared_ptr<BulkInvoke> self)
+   {
+      auto executor = self->work.get_executor();
+      asio::dispatch(executor, [self = std::move(self)]() mutable
+      {
+         // on the handler's executor, where the slot may be accessed safely
+         auto slot = asio::get_associated_cancellation_slot(self->handler);
+         if (slot.is_connected())
+            slot.clear();
+
+         std::vector<R> results;
+         if (!self->error)
+         {
+            results.reserve(self->results.size());
+            for (auto& result : self->results)
+               results.push_back(std::move(*result));
+         }
+
+         auto handler = std::move(self->handler);
+         std::move(handler)(std::move(self->error), std::move(results));
+      });
+   }
+
+   Handler handler;
+   asio::executor_work_guard<Executor> work;
+   std::vector<Input> inputs;
+   F f;
+   std::vector<std::optional<R>> results;
+   std::atomic<size_t> remaining;
+   std::atomic<bool> failed = false;
+   std::atomic<bool> cancelled = false;
+   std::exception_ptr error; // written by whoever sets 'failed', read after the last chunk
+};
+} // namespace asio_coro_detail
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Invokes \p f for every element of \p inputs on the specified executor and completes once, with
+ * \c void(std::exception_ptr, std::vector<R>).
+ *
+ * Unlike calling \c async_invoke() per element, there is no completion, work guard or handler
+ * allocation per element: The inputs are split into a few chunks per hardware thread, each
+ * posted as a single job. The results are in the order of \p inputs. If \p f throws, the
+ * remaining elements are skipped and the operation completes with the first exception and no
+ * results. \p f is called concurrently from multiple threads.
+ *
+ * Cancellation through the handler's associated cancellation slot skips all elements not started
+ * yet and completes with \c asio::error::operation_aborted. The handler's associated allocator is
+ * not used, as the pool threads may release the shared state only after the upcall.
+ */
+template <BOOST_ASIO_EXECUTION_EXECUTOR Executor, std::ranges::input_range Range, typename F,
+          typename CompletionToken, typename Input = std::ranges::range_value_t<Range>,
+          typename R = std::invoke_result_t<F&, Input&>>
+   requires std::invocable<F&, Input&> && (!std::is_void_v<R>) &&
+            asio::completion_token_for<CompletionToken, void(std::exception_ptr, std::vector<R>)>
+auto async_invoke_bulk(Executor& executor, CompletionToken&& token, Range&& inputs, F f)
+{
+   std::vector<Input> values;
+   if constexpr (std::ranges::sized_range<Range>)
+      values.reserve(std::ranges::size(inputs));
+   if constexpr (std::is_lvalue_reference_v<Range>)
+      std::ranges::copy(inputs, std::back_inserter(values));
+   else
+      std::ranges::move(inputs, std::back_inserter(values));
+
+   return asio::async_initiate<CompletionToken, void(std::exception_ptr, std::vector<R>)>(
+      [](auto handler, Executor& pool, std::vector<Input> inputs, F f)
+   {
+      using Handler = decltype(handler);
+      auto ex = asio::get_associated_executor(handler, pool);
+      auto slot = asio::get_associated_cancellation_slot(handler);
+
+      size_t threads = std::max(std::thread::hardware_concurrency(), 1u);
+      size_t chunk_size = std::max<size_t>(inputs.size() / (threads * 4), 1);
+      size_t chunks = std::max<size_t>((inputs.size() + chunk_size - 1) / chunk_size, 1);
+
+      using State = asio_coro_detail::BulkInvoke<Handler, decltype(ex), Input, F, R>;
+      auto state = std::make_shared<State>(std::move(handler), ex, std::move(inputs), std::move(f),
+                                           chunks);
+      if (slot.is_connected())
+         slot.assign([&cancelled = state->cancelled](asio::cancellation_type)
+         { cancelled.store(true, std::memory_order_relaxed); });
+
+      for (size_t i = 0; i < chunks; ++i)
+      {
+         auto begin = i * chunk_size;
+         auto end = std::min(begin + chunk_size, state->inputs.size());
+         asio::post(pool, [state, begin, end]() mutable
+         { state->run(std::move(state), begin, end); });
+      }
+   }, token, std::ref(executor), std::move(values), std::move(f));
+}
+
+/// Function template overload with a default completion token (usually, 'deferred').
+template <BOOST_ASIO_EXECUTION_EXECUTOR Executor, std::ranges::input_range Range, typename F,
+          typename CompletionToken = asio::default_completion_token_t<Executor>>
+   requires std::invocable<F&, std::ranges::range_value_t<Range>&>
+auto async_invoke_bulk(Executor& executor, Range&& inputs, F f)
+{
+   return async_invoke_bulk(executor, CompletionToken(), std::forward<Range>(inputs),
+                            std::move(f));
+}
+
+// -------------------------------------------------------------------------------------------------
+
+namespace asio_coro_detail
+{
+/// The result of \p F, which is passed a \c std::stop_token as the first argument if it takes one.
+template <typename F, typename... Args>
+consteval auto cancellable_result()
+{
+   if constexpr (std::invocable<F, std::stop_token, Args...>)
+      return std::type_identity<std::invoke_result_t<F, std::stop_token, Args...>>{};
+   else
+      return std::type_identity<std::invoke_result_t<F, Args...>>{};
+}
+
+template <typename R>
+struct CancellableSignature
+{
+   using type = void(std::exception_ptr, R);
+};
+
+template <>
+struct CancellableSignature<void>
+{
+   using type = void(std::exception_ptr);
+};
+
+/**
+ * Shared state of \c async_invoke_cancellable(). Whoever moves it out of the \c Queued state
+ * decides: the pool thread runs the callable, the cancellation slot completes the operation
+ * without.
+ *
+ * The state is allocated with \c std::allocator rather than the handler's allocator: The pool job
+ * owns a reference until it returns, which is after the upcall, or long after it if the operation
+ * was cancelled while queued.
+ */
+template <typename Handler, typename Executor, typename R>
+struct CancellableInvoke
+{
+   enum State
+   {
+      Queued,
+      Running,
+      Finished
+   };
+
+   CancellableInvoke(Handler handler, Executor executor)
+      : handler(std::move(handler)), work(std::move(executor))
+   {
+   }
+
+   template <typename F, typename... Args>
+   void run(std::shared_ptr<CancellableInvoke> self, F& f, std::tuple<Args...>& args)
+   {
+      auto expected = Queued;
+      if (!state.compare_exchange_strong(expected, Running, std::memory_order_acq_rel))
+         return; // cancelled while queued
+
+      try
+      {
+         auto invoke = [&]() -> R
+         {
+            if constexpr (std::invocable<F, std::stop_token, Args...>)
+               return std::apply(std::move(f), std::tuple_cat(std::make_tuple(stop.get_token()),
+                                                              std::move(args)));
+            else
+               return std::apply(std::move(f), std::move(args));
+         };
+         if constexpr (std::is_void_v<R>)
+            invoke();
+         else
+            result.emplace(invoke());
+      }
+      catch (...)
+      {
+         error = std::current_exception();
+      }
+      state.store(Finished, std::memory_order_release);
+      complete(std::move(self));
+   }
+
+   /// Called through the cancellation slot, on the handler's executor.
+   void cancel(std::shared_ptr<CancellableInvoke> self)
+   {
+      auto expected = Queued;
+      if (state.compare_exchange_strong(expected, Finished, std::memory_order_acq_rel))
+      {
+         error = std::make_exception_ptr(
+            boost::system::system_error(asio::error::operation_aborted));
+         asio::post(work.get_executor(), [self = std::move(self)]() mutable
+         { complete(std::move(self)); });
+      }
+      else if (expected == Running)
+         stop.request_stop();
+   }
+
+   static void complete(std::shared_ptr<CancellableInvoke> self)
+   {
+      auto executor = self->work.get_executor();
+      asio::dispatch(executor, [self = std::move(self)]() mutable
+      {
+         auto slot = asio::get_associated_cancellation_slot(self->handler);
+         if (slot.is_connected())
+            slot.clear();
+
+         auto handler = std::move(self->handler);
+         if constexpr (std::is_void_v<R>)
+            std::move(handler)(std::move(self->error));
+         else
+            std::move(handler)(std::move(self->error),
+                               self->result ? std::move(*self->result) : R{});
+      });
+   }
+
+   Handler handler;
+   asio::executor_work_guard<Executor> work;
+   std::atomic<State> state = Queued;
+   std::stop_source stop;
+   std::exception_ptr error;
+   std::optional<std::conditional_t<std::is_void_v<R>, std::monostate, R>> result;
+};
+} // namespace asio_coro_detail
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Like \c async_invoke(), but cancellable and completing with \c void(std::exception_ptr, R), or
+ * \c void(std::exception_ptr) if \p f returns \c void. Exceptions thrown by \p f are passed to the
+ * handler instead of escaping on the pool thread.
+ *
+ * Terminal, partial and total cancellation through the handler's associated cancellation slot
+ * drop \p f if it is still queued: It will not be run, and the operation completes right away
+ * with \c asio::error::operation_aborted and a value-initialized \c R. If \p f is already
+ * running, it is not interrupted. But if \p f takes a \c std::stop_token as its first argument,
+ * stop is requested on it so that a long-running callable can give up early:
+ *
+ * \code
+ * auto [ex, result] = co_await async_invoke_cancellable(
+ *    pool, cancel_after(1s, as_tuple(deferred)), [](std::stop_token stop, std::string json)
+ * {
+ *    return validate(json, [&] { return stop.stop_requested(); });
+ * }, std::move(body));
+ * \endcode
+ */
+template <BOOST_ASIO_EXECUTION_EXECUTOR Executor, typename F, typename... Args,
+          typename CompletionToken,
+          typename R = typename decltype(asio_coro_detail::cancellable_result<F, Args...>())::type,
+          typename CompletionSignature = typename asio_coro_detail::CancellableSignature<R>::type>
+   requires(std::invocable<F, Args...> || std::invocable<F, std::stop_token, Args...>) &&
+           (std::is_void_v<R> || std::default_initializable<R>) &&
+           asio::completion_token_for<CompletionToken, CompletionSignature>
+auto async_invoke_cancellable(Executor& executor, CompletionToken&& token, F&& f, Args&&... args)
+{
+   return asio::async_initiate<CompletionToken, CompletionSignature>(
+      [](auto handler, Executor& pool, F f, Args... args)
+   {
+      using Handler = decltype(handler);
+      auto ex = asio::get_associated_executor(handler, pool);
+      auto slot = asio::get_associated_cancellation_slot(handler);
+
+      using State = asio_coro_detail::CancellableInvoke<Handler, decltype(ex), R>;
+      auto state = std::make_shared<State>(std::move(handler), ex);
+      if (slot.is_connected())
+         slot.assign([weak = std::weak_ptr(state)](asio::cancellation_type type)
+         {
+            using enum asio::cancellation_type;
+            if ((type & (terminal | partial | total)) != none)
+               if (auto state = weak.lock())
+                  state->cancel(state);
+         });
+
+      asio::post(pool, [state = std::move(state), f = std::move(f),
+                        args = std::make_tuple(std::move(args)...)]() mutable
+      { state->run(state, f, args); });
+   }, token, std::ref(executor), std::forward<F>(f), std::forward<Args>(args)...);
+}
+
 // =================================================================================================
 
 /**
@@ -0,0 +1,56 @@
+#pragma once
+#include "histogram.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+// =================================================================================================
+
+/**
+ * Result of one run of an echo client, for writing a machine readable record with \c to_json().
+ * The fields under "config" describe the run, the remaining ones what has been measured.
+ */
+struct BenchmarkResult
+{
+   std::string client;
+   std::string mode; // "throughput", "ping-pong", "rate" or "churn"
+   std::string host;
+   uint16_t port = 0;
+   size_t connections = 0;
+   size_t threads = 0;
+   double duration = 0; // configured, in seconds
+   size_t buffer_size = 0;
+   size_t message_size = 0;
+   std::optional<double> rate; // messages per second and connection
+
+   std::vector<size_t> bytes; // echoed, per connection
+   std::chrono::milliseconds elapsed{};
+   std::optional<Histogram> latency;
+   std::optional<Histogram> connect_latency; // churn mode only
+};
+
+/**
+ * Returns \p result as a single line JSON object, like
+ *
+ *   {"client":"client","mode":"throughput","config":{...},"bytes":[...],"total_bytes":...,
+ *    "elapsed_ms":...,"throughput_mib_s":...,"latency_ns":{"count":...,"p50":...,...}}
+ *
+ * "latency_ns" is null if no latencies have been recorded. In churn mode, the number of connections
+ * made, connections per second and "connect_latency_ns" are added.
+ */
+std::string to_json(const BenchmarkResult& result);
+
+/// Writes \p results to \p path as JSON Lines, that is one JSON object per line.
+void write_json(std::span<const BenchmarkResult> results, const std::string& path);
+
+/// Writes a single \p result to \p path, as a JSON object followed by a newline.
+inline void write_json(const BenchmarkResult& result, const std::string& path)
+{
+   write_json(std::span(&result, 1), path);
+}
+
+// =================================================================================================
@@ -0,0 +1,235 @@
+#pragma once
+#include "literals.hpp"
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/execution/context.hpp>
+#include <boost/asio/execution_context.hpp>
+#include <boost/asio/query.hpp>
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+#include <boost/asio/buffer_registration.hpp>
+#endif
+
+#include <cassert>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace asio = boost::asio; // NOLINT(misc-unused-alias-decls)
+
+// =================================================================================================
+
+/**
+ * Pool of fixed size, cache line aligned buffers, shared by everything running on an execution
+ * context. This is an ASIO service, so there is exactly one pool per \c io_context:
+ *
+ * \code
+ * auto data = BufferPool::of(co_await this_coro::executor).acquire();
+ * size_t n = co_await socket.async_read_some(data.buffer());
+ * \endcode
+ *
+ * A connection only needs a buffer while data is actually moving. If sessions wait for the socket
+ * to become readable before acquiring one, idle connections don't hold any buffer at all.
+ *
+ * By default, buffers are allocated on demand and up to \c max_cached of them are kept for reuse.
+ * When built with io_uring, the pool can instead be created with a fixed number of buffers that
+ * are registered with the kernel, so that I/O on them can use the \c *_FIXED operations:
+ *
+ * \code
+ * asio::make_service<BufferPool>(context, BufferPool::Registered{1024});
+ * \endcode
+ */
+class BufferPool : public asio::execution_context::service
+{
+public:
+   static constexpr std::size_t block_size = 64_k;
+   static constexpr std::size_t alignment = 64; // cache line
+   static constexpr std::size_t max_cached = 256;
+
+   static inline asio::execution_context::id id;
+
+   /// Pre-allocates \c count buffers and, with io_uring, registers them with the kernel.
+   struct Registered
+   {
+      std::size_t count;
+   };
+
+   // ----------------------------------------------------------------------------------------------
+
+   /// Handle to a buffer of the pool, returning it on destruction.
+   class Buffer
+   {
+   public:
+      Buffer(Buffer&& other) noexcept
+         : pool_(other.pool_), data_(std::exchange(other.data_, nullptr)), index_(other.index_)
+      {
+      }
+
+      Buffer& operator=(Buffer&& other) noexcept
+      {
+         std::swap(pool_, other.pool_);
+         std::swap(data_, other.data_);
+         std::swap(index_, other.index_);
+         return *this;
+      }
+
+      ~Buffer()
+      {
+         if (data_)
+            pool_->release(data_, index_);
+      }
+
+      char* data() noexcept { return data_; }
+      static constexpr std::size_t size() noexcept { return block_size; }
+
+      asio::mutable_buffer buffer(std::size_t n = block_size) noexcept
+      {
+         assert(n <= block_size);
+         return {data_, n};
+      }
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+      /**
+       * Returns the registered buffer, if the pool has been created with \c Registered. Pass it
+       * to socket and file operations instead of \c buffer(), so that they use the \c *_FIXED
+       * operations of io_uring.
+       */
+      std::optional<asio::mutable_registered_buffer> registered() const
+      {
+         if (index_ < 0)
+            return std::nullopt;
+         return pool_->registration_->at(std::size_t(index_));
+      }
+#endif
+
+   private:
+      friend class BufferPool;
+      Buffer(BufferPool* pool, char* data, std::ptrdiff_t index)
+         : pool_(pool), data_(data), index_(index)
+      {
+      }
+
+      BufferPool* pool_;
+      char* data_;
+      std::ptrdiff_t index_; // index into the registered arena, or -1
+   };
+
+   // ----------------------------------------------------------------------------------------------
+
+   explicit BufferPool(asio::execution_context& context) : service(context)
+   {
+      free_.reserve(max_cached);
+   }
+
+   BufferPool(asio::execution_context& context, Registered registered) : BufferPool(context)
+   {
+      arena_ = allocate(registered.count * block_size);
+      free_registered_.reserve(registered.count);
+      for (std::size_t i = registered.count; i-- > 0;)
+         free_registered_.push_back(i);
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+      std::vector<asio::mutable_buffer> buffers;
+      for (std::size_t i = 0; i < registered.count; ++i)
+         buffers.emplace_back(arena_ + i * block_size, block_size);
+      registration_.emplace(asio::register_buffers(context, buffers));
+#endif
+   }
+
+   ~BufferPool() override
+   {
+      for (auto* data : free_)
+         deallocate(data);
+      if (arena_)
+         deallocate(arena_);
+   }
+
+   /// Returns the buffer pool of the execution context of \p executor.
+   template <typename Executor>
+   static BufferPool& of(const Executor& executor)
+   {
+      return asio::use_service<BufferPool>(asio::query(executor, asio::execution::context));
+   }
+
+   /**
+    * Takes a buffer from the pool, allocating a new one if none is free. In registered mode, the
+    * registered buffers are handed out first. If they are exhausted, the pool falls back to
+    * allocating unregistered ones.
+    */
+   Buffer acquire()
+   {
+      {
+         std::lock_guard lock(mutex_);
+         if (!free_registered_.empty())
+         {
+            auto index = free_registered_.back();
+            free_registered_.pop_back();
+            return Buffer(this, arena_ + index * block_size, std::ptrdiff_t(index));
+         }
+         if (!free_.empty())
+         {
+            auto* data = free_.back();
+            free_.pop_back();
+            return Buffer(this, data, -1);
+         }
+      }
+      return Buffer(this, allocate(block_size), -1);
+   }
+
+   /// Number of buffers that are currently free, for diagnostics.
+   std::size_t available() const
+   {
+      std::lock_guard lock(mutex_);
+      return free_registered_.size() + free_.size();
+   }
+
+private:
+   void shutdown() override
+   {
+#if defined(BOOST_ASIO_HAS_IO_URING)
+      registration_.reset();
+#endif
+   }
+
+   /// Both free lists have been reserved to their maximum size, so this never allocates.
+   void release(char* data, std::ptrdiff_t index) noexcept
+   {
+      {
+         std::lock_guard lock(mutex_);
+         if (index >= 0)
+         {
+            free_registered_.push_back(std::size_t(index));
+            return;
+         }
+         if (free_.size() < max_cached)
+         {
+            free_.push_back(data);
+            return;
+         }
+      }
+      deallocate(data);
+   }
+
+   static char* allocate(std::size_t size)
+   {
+      return static_cast<char*>(::operator new(size, std::align_val_t{alignment}));
+   }
+
+   static void deallocate(char* data) noexcept
+   {
+      ::operator delete(data, std::align_val_t{alignment});
+   }
+
+   mutable std::mutex mutex_;
+   std::vector<char*> free_;
+   std::vector<std::size_t> free_registered_;
+   char* arena_ = nullptr;
+
+#if defined(BOOST_ASIO_HAS_IO_URING)
+   std::optional<asio::buffer_registration<std::vector<asio::mutable_buffer>>> registration_;
+#endif
+};
+
+// =================================================================================================
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <vector>
+
+// =================================================================================================
+
+/**
+ * Latency histogram with logarithmic buckets, in the spirit of HdrHistogram.
+ *
+ * Values are recorded as unsigned integers, usually nanoseconds. Each power of two range is split
+ * into 2^SubBucketBits linear sub-buckets, so the relative error of any reported value is bounded
+ * by 2^-SubBucketBits (about 1.6% for the default of 6 bits), independent of the magnitude.
+ *
+ * Values are clamped to 2^MaxValueBits - 1, which is about 18 minutes when recording nanoseconds.
+ * With the defaults, a histogram takes about 18 KiB, regardless of the number of values recorded.
+ *
+ * Recording is not synchronized. Use one histogram per connection or thread and \c merge() them.
+ */
+class Histogram
+{
+public:
+   static constexpr unsigned SubBucketBits = 6;
+   static constexpr unsigned MaxValueBits = 40;
+
+   void record(uint64_t value) noexcept
+   {
+      value = std::min(value, max_trackable);
+      ++counts_[index_of(value)];
+      ++count_;
+      sum_ += value;
+      min_ = std::min(min_, value);
+      max_ = std::max(max_, value);
+   }
+
+   template <typename Rep, typename Period>
+   void record(std::chrono::duration<Rep, Period> duration) noexcept
+   {
+      auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+      record(static_cast<uint64_t>(std::max<decltype(ns)>(ns, 0)));
+   }
+
+   void merge(const Histogram& other) noexcept
+   {
+      for (size_t i = 0; i < counts_.size(); ++i)
+         counts_[i] += other.counts_[i];
+      count_ += other.count_;
+      sum_ += other.sum_;
+      min_ = std::min(min_, other.min_);
+      max_ = std::max(max_, other.max_);
+   }
+
+   void reset() noexcept { *this = Histogram{}; }
+
+   uint64_t count() const noexcept { return count_; }
+   uint64_t min() const noexcept { return count_ ? min_ : 0; }
+   uint64_t max() const noexcept { return max_; }
+   double mean() const noexcept { return count_ ? double(sum_) / double(count_) : 0.0; }
+
+   /**
+    * Returns the value at the given \p percentile (0..100), which is the highest value equivalent
+    * to the bucket containing that percentile, but never more than the maximum value recorded.
+    */
+   uint64_t percentile(double percentile) const noexcept
+   {
+      if (count_ == 0)
+         return 0;
+
+      percentile = std::clamp(percentile, 0.0, 100.0);
+      auto target = static_cast<uint64_t>(percentile / 100.0 * double(count_) + 0.5);
+      target = std::clamp<uint64_t>(target, 1, count_);
+
+      uint64_t cumulative = 0;
+      for (size_t i = 0; i < counts_.size(); ++i)
+      {
+         cumulative += counts_[i];
+         if (cumulative >= target)
+            return std::min(highest_equivalent(i), max_);
+      }
+      return max_;
+   }
+
+private:
+   static constexpr uint64_t sub_bucket_count = uint64_t{1} << SubBucketBits;
+   static constexpr uint64_t max_trackable = (uint64_t{1} << MaxValueBits) - 1;
+   static constexpr size_t bucket_count = (MaxValueBits - SubBucketBits + 1) * sub_bucket_count;
+
+   /// Values below 2^SubBucketBits map 1:1, above that each power of two gets its own range.
+   static constexpr size_t index_of(uint64_t value) noexcept
+   {
+      if (value < sub_bucket_count)
+         return value;
+
+      auto shift = unsigned(std::bit_width(value)) - 1 - SubBucketBits;
+      return size_t(shift) * sub_bucket_count + (value >> shift);
+   }
+
+   static constexpr uint64_t highest_equivalent(size_t index) noexcept
+   {
+      if (index < sub_bucket_count)
+         return index;
+
+      auto shift = unsigned(index / sub_bucket_count) - 1;
+      auto sub = index - shift * sub_bucket_count;
+      return ((sub + 1) << shift) - 1;
+   }
+
+   std::vector<uint64_t> counts_ = std::vector<uint64_t>(bucket_count);
+   uint64_t count_ = 0;
+   uint64_t sum_ = 0;
+   uint64_t min_ = std::numeric_limits<uint64_t>::max();
+   uint64_t max_ = 0;
+};
+
+// =================================================================================================
+
+/// Format nanoseconds scaled to a suitable unit (ns, µs, ms, s).
+struct Latency
+{
+   uint64_t ns;
+};
+
+template <>
+struct std::formatter<Latency>
+{
+   constexpr auto parse(std::format_parse_context& ctx) { return ctx.begin(); }
+
+   auto format(const Latency& latency, std::format_context& ctx) const
+   {
+      if (latency.ns < 1'000)
+         return std::format_to(ctx.out(), "{}ns", latency.ns);
+      else if (latency.ns < 1'000'000)
+         return std::format_to(ctx.out(), "{:.1f}µs", double(latency.ns) / 1e3);
+      else if (latency.ns < 1'000'000'000)
+         return std::format_to(ctx.out(), "{:.1f}ms", double(latency.ns) / 1e6);
+      else
+         return std::format_to(ctx.out(), "{:.2f}s", double(latency.ns) / 1e9);
+   }
+};
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Formats a one line summary of a histogram of nanosecond values, like
+ *
+ *   n=12345 p50=48.1µs p90=52.3µs p99=71.2µs p99.9=140.8µs max=1.2ms
+ */
+template <>
+struct std::formatter<Histogram>
+{
+   constexpr auto parse(std::format_parse_context& ctx) { return ctx.begin(); }
+
+   auto format(const Histogram& histogram, std::format_context& ctx) const
+   {
+      auto out = std::format_to(ctx.out(), "n={}", histogram.count());
+      for (auto [name, p] : {std::pair{"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p99.9", 99.9}})
+         out = std::format_to(out, " {}={}", name, Latency{histogram.percentile(p)});
+      return std::format_to(out, " max={}", Latency{histogram.max()});
+   }
+};
+
+// =================================================================================================
@@ -0,0 +1,83 @@
+#pragma once
+#include "histogram.hpp"
+
+#include <boost/asio/io_context.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// =================================================================================================
+
+/**
+ * Runs an \c io_context like \c io_context::run(), but records runtime metrics per thread: the
+ * number of handlers executed, their execution times and how much of the time the thread has been
+ * busy or idle. Call \c run() from every thread that should run the context, and \c snapshot()
+ * from any thread to read the metrics:
+ *
+ * \code
+ * InstrumentedRunner runner;
+ * std::jthread worker([&] { runner.run(context); });
+ * runner.run(context);
+ * std::println("busy: {:.0f}%", runner.snapshot().total.busy_ratio() * 100);
+ * \endcode
+ *
+ * Handlers that are ready are executed with \c poll_one() and timed individually. When there is
+ * nothing to do, the thread blocks in \c run_one(), which waits for and executes the next
+ * handler. Those two can't be told apart, so the CPU time used by \c run_one() is taken as busy
+ * time and handler execution time, the rest as idle time. A handler blocking in a system call
+ * while the thread is waiting in \c run_one() is therefore counted as idle.
+ *
+ * ASIO doesn't expose the length of its queue. As a proxy, the number of handlers executed back to
+ * back without blocking is recorded as the batch size. Large batches mean that work is piling up.
+ *
+ * Each thread publishes its metrics every \c publish_interval, so a snapshot may lag behind by
+ * that much.
+ */
+class InstrumentedRunner
+{
+public:
+   static constexpr std::chrono::milliseconds publish_interval{100};
+
+   struct ThreadStats
+   {
+      uint64_t handlers = 0;
+      std::chrono::nanoseconds busy{};
+      std::chrono::nanoseconds idle{};
+      Histogram handler_time; // in nanoseconds
+      Histogram batch_size;   // handlers executed without blocking in between
+
+      void merge(const ThreadStats& other);
+
+      /// Fraction of the time spent executing handlers, 0..1.
+      double busy_ratio() const;
+   };
+
+   struct Snapshot
+   {
+      ThreadStats total;
+      std::vector<ThreadStats> threads; // in the order the threads called run()
+   };
+
+   /// Runs \p context on the calling thread until it is stopped or runs out of work.
+   size_t run(boost::asio::io_context& context);
+
+   /// Returns the metrics of all threads that have called \c run(). Safe to call from any thread.
+   Snapshot snapshot() const;
+
+private:
+   struct Slot
+   {
+      mutable std::mutex mutex;
+      ThreadStats stats;
+   };
+
+   Slot& add_slot();
+
+   mutable std::mutex mutex_;
+   std::vector<std::unique_ptr<Slot>> slots_;
+};
+
+// =================================================================================================
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <boost/asio/any_completion_handler.hpp>
+#include <boost/asio/any_io_executor.hpp>
+#include <boost/asio/associated_cancellation_slot.hpp>
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/execution/outstanding_work.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/prefer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace asio = boost::asio; // NOLINT(misc-unused-alias-decls)
+
+// =================================================================================================
+
+/**
+ * Bounded channel for handing over values from any number of threads to a single consumer
+ * coroutine, typically running on another IO context.
+ *
+ * Unlike posting a handler per value, sending doesn't allocate and doesn't touch the scheduler of
+ * the receiving context. Values are stored in a lock-free ring buffer (Dmitry Vyukov's bounded
+ * queue). The consumer is only woken up if it is actually waiting: The first value sent after the
+ * consumer has run out of values posts a single wakeup, all values sent until the consumer gets
+ * around to receive them are picked up without any further post. So under load, there is one
+ * post per batch instead of one per value:
+ *
+ * \code
+ * MpscChannel<Message> channel(1024);
+ *
+ * // any thread
+ * co_await channel.send(std::move(message));   // or channel.try_send()
+ *
+ * // consumer
+ * while (auto message = co_await channel.receive())
+ *    process(*message);
+ * \endcode
+ *
+ * Producers that find the channel full wait on a mutex protected list, which is only looked at
+ * by the consumer if there are waiting producers. The consumer side must not be used from more
+ * than one coroutine at a time. Waiting for a value supports cancellation, waiting for space does
+ * not. The channel must outlive all pending operations.
+ */
+template <typename T>
+class MpscChannel
+{
+public:
+   /// Creates a channel holding up to \p capacity values, rounded up to a power of two.
+   explicit MpscChannel(std::size_t capacity)
+      : mask_(std::bit_ceil(std::max<std::size_t>(capacity, 2)) - 1),
+        cells_(std::make_unique<Cell[]>(mask_ + 1))
+   {
+      for (std::size_t i = 0; i <= mask_; ++i)
+         cells_[i].sequence.store(i, std::memory_order_relaxed);
+   }
+
+   ~MpscChannel()
+   {
+      while (try_receive())
+         ;
+   }
+
+   MpscChannel(const MpscChannel&) = delete;
+   MpscChannel& operator=(const MpscChannel&) = delete;
+
+   std::size_t capacity() const noexcept { return mask_ + 1; }
+
+   // ----------------------------------------------------------------------------------------------
+
+   /**
+    * Sends \p value, unless the channel is full or closed. On failure, \p value is left untouched
+    * and false is returned. Safe to call from any thread.
+    */
+   template <typename U>
+   bool try_send(U&& value)
+   {
+      if (closed_.load(std::memory_order_relaxed))
+         return false;
+
+      auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+      Cell* cell;
+      for (;;)
+      {
+         cell = &cells_[pos & mask_];
+         auto sequence = cell->sequence.load(std::memory_order_acquire);
+         auto diff = std::intptr_t(sequence) - std::intptr_t(pos);
+         if (diff == 0)
+         {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+               break;
+         }
+         else if (diff < 0)
+            return false; // full
+         else
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+
+      new (cell->storage) T(std::forward<U>(value));
+      cell->sequence.store(pos + 1, std::memory_order_release);
+
+      //
+      // Pairs with the fence in async_wait_value(): Either the consumer sees the new value when
+      // checking again after announcing that it is waiting, or this thread sees the announcement.
+      //
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (consumer_waiting_.load(std::memory_order_relaxed))
+         wake_consumer({});
+      return true;
+   }
+
+   /// Sends \p value, waiting for space if the channel is full. Returns false if it is closed.
+   asio::awaitable<bool> send(T value)
+   {
+      while (!try_send(std::move(value)))
+      {
+         if (closed_.load(std::memory_order_relaxed))
+            co_return false;
+         co_await async_wait_space(asio::use_awaitable);
+      }
+      co_return true;
+   }
+
+   // ----------------------------------------------------------------------------------------------
+
+   /// Takes the next value, if there is one. Consumer only.
+   std::optional<T> try_receive()
+   {
+      auto& cell = cells_[dequeue_pos_ & mask_];
+      if (cell.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1)
+         return std::nullopt;
+
+      auto* ptr = std::launder(reinterpret_cast<T*>(cell.storage));
+      std::optional<T> value(std::move(*ptr));
+      ptr->~T();
+      cell.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+      ++dequeue_pos_;
+
+      std::atomic_thread_fence(std::memory_order_seq_cst); // pairs with async_wait_space()
+      if (producers_waiting_.load(std::memory_order_relaxed))
+         wake_producers();
+      return value;
+   }
+
+   /**
+    * Returns the next value, waiting for one if the channel is empty. Returns \c std::nullopt once
+    * the channel has been closed and all values sent before have been received. Consumer only.
+    */
+   asio::awaitable<std::optional<T>> receive()
+   {
+      for (;;)
+      {
+         if (auto value = try_receive())
+            co_return value;
+         if (closed_.load(std::memory_order_acquire) && !readable())
+            co_return std::nullopt;
+         co_await async_wait_value(asio::use_awaitable);
+      }
+   }
+
+   /**
+    * Waits until the channel is not empty or has been closed, completing with \c void(error_code).
+    * Completes with \c operation_aborted if cancelled. Consumer only.
+    */
+   template <asio::completion_token_for<void(boost::system::error_code)> CompletionToken>
+   auto async_wait_value(CompletionToken&& token)
+   {
+      return asio::async_initiate<CompletionToken, void(boost::system::error_code)>(
+         [this](auto handler)
+      {
+         assert(!consumer_.handler && "only a single consumer may wait at a time");
+         auto slot = asio::get_associated_cancellation_slot(handler);
+         consumer_ = Waiter<void(boost::system::error_code)>(std::move(handler));
+
+         if (slot.is_connected())
+            slot.assign([this](asio::cancellation_type)
+            { wake_consumer(asio::error::operation_aborted); });
+
+         //
+         // Announce that the consumer is waiting, then check again. See try_send().
+         //
+         consumer_waiting_.store(true, std::memory_order_release); // publishes consumer_
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+         if (readable() || closed_.load(std::memory_order_relaxed))
+            wake_consumer({});
+      }, token);
+   }
+
+   // ----------------------------------------------------------------------------------------------
+
+   /// Closes the channel. Values sent before can still be received. Safe to call from any thread.
+   void close()
+   {
+      closed_.store(true, std::memory_order_seq_cst);
+      if (consumer_waiting_.load(std::memory_order_seq_cst))
+         wake_consumer({});
+      wake_producers();
+   }
+
+private:
+   struct alignas(64) Cell // one per cache line, so that producers don't contend on neighbors
+   {
+      std::atomic<std::size_t> sequence;
+      alignas(T) std::byte storage[sizeof(T)];
+   };
+
+   /// A type-erased handler plus an executor that keeps its context alive while it waits.
+   template <typename Signature>
+   struct Waiter
+   {
+      Waiter() = default;
+
+      template <typename Handler>
+         requires(!std::same_as<std::decay_t<Handler>, Waiter>)
+      explicit Waiter(Handler&& h)
+         : work(asio::prefer(asio::get_associated_executor(h),
+                             asio::execution::outstanding_work.tracked)),
+           handler(std::forward<Handler>(h))
+      {
+      }
+
+      asio::any_io_executor work;
+      asio::any_completion_handler<Signature> handler;
+   };
+
+   bool readable() const
+   {
+      auto& cell = cells_[dequeue_pos_ & mask_];
+      return cell.sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1;
+   }
+
+   /**
+    * Completes the waiting consumer, if it is still waiting. Called by producers, the cancellation
+    * slot or the consumer itself, whoever resets the flag first owns the handler.
+    */
+   void wake_consumer(boost::system::error_code ec)
+   {
+      if (!consumer_waiting_.exchange(false, std::memory_order_acquire))
+         return;
+
+      auto waiter = std::exchange(consumer_, {});
+      asio::post(waiter.work, [handler = std::move(waiter.handler), ec]() mutable
+      {
+         // runs on the consumer's executor, where the slot may be accessed safely
+         auto slot = asio::get_associated_cancellation_slot(handler);
+         if (slot.is_connected())
+            slot.clear();
+         std::move(handler)(ec);
+      });
+   }
+
+   template <asio::completion_token_for<void()> CompletionToken>
+   auto async_wait_space(CompletionToken&& token)
+   {
+      return asio::async_initiate<CompletionToken, void()>([this](auto handler)
+      {
+         std::lock_guard lock(mutex_);
+         producers_.emplace_back(std::move(handler));
+         producers_waiting_.store(true, std::memory_order_relaxed);
+
+         // pairs with the fence in try_receive()
+         std::atomic_thread_fence(std::memory_order_seq_cst);
+         if (!full() || closed_.load(std::memory_order_relaxed))
+            wake_producers_locked();
+      }, token);
+   }
+
+   bool full() const
+   {
+      auto pos = enqueue_pos_.load(std::memory_order_relaxed);
+      auto sequence = cells_[pos & mask_].sequence.load(std::memory_order_acquire);
+      return std::intptr_t(sequence) - std::intptr_t(pos) < 0;
+   }
+
+   void wake_producers()
+   {
+      std::lock_guard lock(mutex_);
+      wake_producers_locked();
+   }
+
+   void wake_producers_locked()
+   {
+      producers_waiting_.store(false, std::memory_order_relaxed);
+      for (auto& waiter : std::exchange(producers_, {}))
+         asio::post(waiter.work, std::move(waiter.handler));
+   }
+
+   const std::size_t mask_;
+   std::unique_ptr<Cell[]> cells_;
+   alignas(64) std::atomic<std::size_t> enqueue_pos_ = 0;
+   alignas(64) std::size_t dequeue_pos_ = 0;
+   Waiter<void(boost::system::error_code)> consumer_;
+   std::atomic<bool> consumer_waiting_ = false;
+   std::atomic<bool> closed_ = false;
+
+   alignas(64) std::mutex mutex_;
+   std::vector<Waiter<void()>> producers_;
+   std::atomic<bool> producers_waiting_ = false;
+};
+
+// =================================================================================================
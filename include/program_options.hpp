@@ -1,5 +1,13 @@
 #pragma once
 
 #include <boost/asio/io_context.hpp>
+#include <boost/program_options/options_description.hpp>
 
 int run(boost::asio::io_context& context, int argc, char* argv[]);
+
+/**
+ * Like above, but also accepting the program specific \p options on the command line. Their
+ * values are stored before the IO context is run.
+ */
+int run(boost::asio::io_context& context, int argc, char* argv[],
+        const boost::program_options::options_description& options);
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+// =================================================================================================
+
+/**
+ * Fixed size buffer that is recycled through a per-thread free list instead of being freed.
+ *
+ * ASIO already recycles coroutine frames through its per-thread recycling allocator, but only
+ * small ones. A session coroutine with a \c std::array<char, 64 * 1024> in its frame is too large
+ * for that, so every accepted connection costs a 64 KiB malloc() and free(). Holding the buffer
+ * in a \c RecycledBuffer instead keeps the frame small enough to be recycled by ASIO, and the
+ * buffer itself is taken from the free list of the thread that creates the session:
+ *
+ * \code
+ * awaitable<void> session(tcp::socket socket)
+ * {
+ *    RecycledBuffer<64 * 1024> data;
+ *    for (;;)
+ *    {
+ *       size_t n = co_await socket.async_read_some(buffer(data.data(), data.size()));
+ *       co_await async_write(socket, buffer(data.data(), n));
+ *    }
+ * }
+ * \endcode
+ *
+ * A buffer released on a different thread than it was acquired on goes to the free list of the
+ * releasing thread. At most \p MaxCached buffers are kept per thread, the rest is freed.
+ */
+template <std::size_t Size, std::size_t MaxCached = 64>
+class RecycledBuffer
+{
+public:
+   static constexpr std::size_t alignment = 64; // cache line
+
+   RecycledBuffer() : data_(acquire()) {}
+   ~RecycledBuffer()
+   {
+      if (data_)
+         release(data_);
+   }
+
+   RecycledBuffer(RecycledBuffer&& other) noexcept : data_(std::exchange(other.data_, nullptr)) {}
+   RecycledBuffer& operator=(RecycledBuffer&& other) noexcept
+   {
+      std::swap(data_, other.data_);
+      return *this;
+   }
+
+   char* data() noexcept { return data_; }
+   const char* data() const noexcept { return data_; }
+   static constexpr std::size_t size() noexcept { return Size; }
+
+   /// Number of buffers currently cached by the calling thread.
+   static std::size_t cached() { return free_list().blocks.size(); }
+
+private:
+   struct FreeList
+   {
+      std::vector<char*> blocks;
+      FreeList() { blocks.reserve(MaxCached); } // release() must not throw
+      ~FreeList()
+      {
+         for (auto* block : blocks)
+            ::operator delete(block, std::align_val_t{alignment});
+      }
+   };
+
+   static FreeList& free_list()
+   {
+      thread_local FreeList list;
+      return list;
+   }
+
+   static char* acquire()
+   {
+      auto& list = free_list();
+      if (list.blocks.empty())
+         return static_cast<char*>(::operator new(Size, std::align_val_t{alignment}));
+
+      auto* block = list.blocks.back();
+      list.blocks.pop_back();
+      return block;
+   }
+
+   static void release(char* block) noexcept
+   {
+      auto& list = free_list();
+      if (list.blocks.size() < MaxCached)
+         list.blocks.push_back(block);
+      else
+         ::operator delete(block, std::align_val_t{alignment});
+   }
+
+   char* data_;
+};
+
+// =================================================================================================
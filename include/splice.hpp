@@ -0,0 +1,125 @@
+#pragma once
+#include "literals.hpp"
+
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/system/system_error.hpp>
+
+#include <concepts>
+#include <utility>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace asio = boost::asio; // NOLINT(misc-unused-alias-decls)
+
+// =================================================================================================
+
+/**
+ * A stream backed by a file descriptor that supports waiting for readiness, like \c tcp::socket
+ * or \c posix::stream_descriptor. Note that \c readable_pipe and \c writable_pipe are not, as they
+ * lack \c async_wait().
+ */
+template <typename T>
+concept SpliceableStream = requires(T& stream) {
+   { stream.native_handle() } -> std::convertible_to<int>;
+   stream.native_non_blocking(true);
+   stream.async_wait(T::wait_read, asio::deferred);
+   stream.async_wait(T::wait_write, asio::deferred);
+};
+
+// -------------------------------------------------------------------------------------------------
+
+namespace asio_coro_detail
+{
+[[noreturn]] inline void throw_errno(const char* what)
+{
+   throw boost::system::system_error(errno, boost::system::system_category(), what);
+}
+
+/// Non-blocking pipe, closed on destruction.
+class SplicePipe
+{
+public:
+   SplicePipe()
+   {
+      if (::pipe2(fds_, O_NONBLOCK | O_CLOEXEC) != 0)
+         throw_errno("pipe2");
+   }
+   ~SplicePipe()
+   {
+      ::close(fds_[0]);
+      ::close(fds_[1]);
+   }
+   SplicePipe(const SplicePipe&) = delete;
+   SplicePipe& operator=(const SplicePipe&) = delete;
+
+   int read_end() const { return fds_[0]; }
+   int write_end() const { return fds_[1]; }
+
+private:
+   int fds_[2];
+};
+} // namespace asio_coro_detail
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Relays everything from \p in to \p out until EOF, without copying the data through user space.
+ *
+ * The data is moved with splice(2) from \p in into an intermediate pipe and from there into
+ * \p out. Whenever one of the descriptors would block, the coroutine waits for readiness using
+ * \c async_wait(), so this works with both the epoll and the io_uring backend of ASIO. Both
+ * streams are switched to non-blocking mode.
+ *
+ * Returns the number of bytes relayed. Errors are thrown as \c system_error, cancellation is
+ * supported while waiting.
+ */
+template <SpliceableStream In, SpliceableStream Out>
+asio::awaitable<size_t> splice_relay(In& in, Out& out, size_t chunk_size = 64_k)
+{
+   in.native_non_blocking(true);
+   out.native_non_blocking(true);
+
+   asio_coro_detail::SplicePipe pipe;
+   constexpr unsigned flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+
+   size_t total = 0;
+   for (;;)
+   {
+      //
+      // The pipe is always drained completely before reading again, so EAGAIN here means that
+      // there is no data available on the input.
+      //
+      auto n = ::splice(in.native_handle(), nullptr, pipe.write_end(), nullptr, chunk_size, flags);
+      if (n == 0)
+         break; // EOF
+      else if (n < 0 && errno == EAGAIN)
+      {
+         co_await in.async_wait(In::wait_read, asio::deferred);
+         continue;
+      }
+      else if (n < 0 && errno == EINTR)
+         continue;
+      else if (n < 0)
+         asio_coro_detail::throw_errno("splice (in)");
+
+      for (auto pending = size_t(n); pending > 0;)
+      {
+         auto m = ::splice(pipe.read_end(), nullptr, out.native_handle(), nullptr, pending, flags);
+         if (m < 0 && errno == EAGAIN)
+            co_await out.async_wait(Out::wait_write, asio::deferred);
+         else if (m < 0 && errno == EINTR)
+            continue;
+         else if (m < 0)
+            asio_coro_detail::throw_errno("splice (out)");
+         else
+            pending -= size_t(m);
+      }
+
+      total += size_t(n);
+   }
+   co_return total;
+}
+
+// =================================================================================================
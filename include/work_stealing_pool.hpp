@@ -0,0 +1,290 @@
+#pragma once
+
+#include <boost/asio/execution.hpp>
+#include <boost/asio/execution_context.hpp>
+#include <boost/asio/recycling_allocator.hpp>
+
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace asio = boost::asio; // NOLINT(misc-unused-alias-decls)
+
+// =================================================================================================
+
+/**
+ * Thread pool with one task queue per worker thread, as a drop-in for \c asio::thread_pool:
+ *
+ * \code
+ * WorkStealingPool pool(8);
+ * auto result = co_await async_invoke(pool.get_executor(), [] { return validate(json); });
+ * co_await post(bind_executor(pool));
+ * \endcode
+ *
+ * \c asio::thread_pool has a single queue, so every submission and every dequeue contends on the
+ * same mutex. Here, tasks submitted by a worker go to the back of its own queue and are taken
+ * from there again (LIFO, which is cache friendly for continuations). Tasks from other threads
+ * are distributed round-robin. A worker running out of tasks steals from the front of the
+ * queues of the others before going to sleep. Each queue has its own mutex, which is contended
+ * only while stealing.
+ *
+ * The bookkeeping is per worker, too: Each queue keeps its own size, and each thread counts the
+ * work it has started and finished, so running a task doesn't write to any shared cache line.
+ * Only a worker going to sleep and \c join() add up the counts of all of them.
+ *
+ * The executor satisfies ASIO's executor concept and can be converted to \c any_io_executor, so
+ * it works with \c co_spawn(), \c post(), \c bind_executor() and \c async_invoke().
+ */
+class WorkStealingPool : public asio::execution_context
+{
+   class Task;
+
+public:
+   class executor_type;
+
+   explicit WorkStealingPool(std::size_t threads = std::thread::hardware_concurrency());
+   ~WorkStealingPool();
+
+   executor_type get_executor() noexcept;
+
+   /// Waits until there is no more work, then stops and joins the threads.
+   void join();
+
+   /// Stops the threads as soon as possible. Tasks not yet started are discarded.
+   void stop();
+
+   /// True if called from one of the worker threads of this pool.
+   bool running_in_this_thread() const noexcept;
+
+private:
+   // ----------------------------------------------------------------------------------------------
+
+   /**
+    * Move-only, type-erased nullary function. The memory is taken from ASIO's per-thread
+    * recycling allocator and released before the function is called, so that a task submitting
+    * another one can reuse it.
+    */
+   class Task
+   {
+   public:
+      template <typename F>
+         requires(!std::same_as<std::decay_t<F>, Task>)
+      explicit Task(F&& f)
+      {
+         using Impl = TaskImpl<std::decay_t<F>>;
+         typename Impl::allocator_type allocator;
+         auto* impl = std::allocator_traits<typename Impl::allocator_type>::allocate(allocator, 1);
+         impl_ = new (impl) Impl(std::forward<F>(f));
+      }
+
+      Task(Task&& other) noexcept : impl_(std::exchange(other.impl_, nullptr)) {}
+      Task& operator=(Task&& other) noexcept
+      {
+         std::swap(impl_, other.impl_);
+         return *this;
+      }
+
+      ~Task()
+      {
+         if (impl_)
+            impl_->complete(impl_, false);
+      }
+
+      void operator()()
+      {
+         auto* impl = std::exchange(impl_, nullptr);
+         impl->complete(impl, true);
+      }
+
+   private:
+      struct TaskBase
+      {
+         void (*complete)(TaskBase* self, bool invoke);
+      };
+
+      template <typename F>
+      struct TaskImpl : TaskBase
+      {
+         using allocator_type = asio::recycling_allocator<TaskImpl>;
+
+         explicit TaskImpl(F f) : TaskBase{&TaskImpl::complete}, function(std::move(f)) {}
+
+         static void complete(TaskBase* base, bool invoke)
+         {
+            auto* self = static_cast<TaskImpl*>(base);
+            F function(std::move(self->function));
+            allocator_type allocator;
+            self->~TaskImpl();
+            std::allocator_traits<allocator_type>::deallocate(allocator, self, 1);
+            if (invoke)
+               std::move(function)();
+         }
+
+         F function;
+      };
+
+      TaskBase* impl_;
+   };
+
+   // ----------------------------------------------------------------------------------------------
+
+   /// Monotonic counts of the work (tasks and tracked executors) started and finished by a thread.
+   struct WorkCounts
+   {
+      std::atomic<std::size_t> started = 0;
+      std::atomic<std::size_t> finished = 0;
+   };
+
+   struct alignas(64) Worker
+   {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+      std::atomic<std::size_t> queued = 0; // size of 'tasks', readable without the mutex
+      WorkCounts work;
+   };
+
+   void submit(Task task);
+   bool try_run(std::size_t index);
+   void run(std::size_t index);
+   void work_started() noexcept;
+   void work_finished() noexcept;
+   WorkCounts& work_counts() noexcept;
+   std::size_t outstanding() const noexcept;
+   bool any_queued() const noexcept;
+   void wake_all();
+
+   std::vector<std::unique_ptr<Worker>> workers_;
+   std::vector<std::thread> threads_;
+
+   alignas(64) WorkCounts external_; // of threads outside of the pool
+   alignas(64) std::atomic<std::size_t> sleepers_ = 0;
+   std::atomic<bool> joining_ = false;
+   std::atomic<bool> stopped_ = false;
+   std::mutex sleep_mutex_;
+   std::condition_variable sleep_cv_;
+};
+
+// =================================================================================================
+
+/**
+ * Executor of a \c WorkStealingPool. Execution never blocks, unless \c blocking.possibly is
+ * required, in which case functions submitted from a worker thread of the same pool run inline.
+ * With \c outstanding_work.tracked, the pool doesn't finish \c join() while the executor exists.
+ */
+class WorkStealingPool::executor_type
+{
+public:
+   executor_type(const executor_type& other) noexcept
+      : pool_(other.pool_), tracked_(other.tracked_), possibly_(other.possibly_)
+   {
+      if (tracked_)
+         pool_->work_started();
+   }
+
+   executor_type(executor_type&& other) noexcept
+      : pool_(other.pool_), tracked_(std::exchange(other.tracked_, false)),
+        possibly_(other.possibly_)
+   {
+   }
+
+   executor_type& operator=(executor_type other) noexcept
+   {
+      std::swap(pool_, other.pool_);
+      std::swap(tracked_, other.tracked_);
+      std::swap(possibly_, other.possibly_);
+      return *this;
+   }
+
+   ~executor_type()
+   {
+      if (tracked_)
+         pool_->work_finished();
+   }
+
+   // ----------------------------------------------------------------------------------------------
+
+   WorkStealingPool& query(asio::execution::context_t) const noexcept { return *pool_; }
+
+   asio::execution::blocking_t query(asio::execution::blocking_t) const noexcept
+   {
+      return possibly_ ? asio::execution::blocking_t(asio::execution::blocking.possibly)
+                       : asio::execution::blocking_t(asio::execution::blocking.never);
+   }
+
+   asio::execution::outstanding_work_t query(asio::execution::outstanding_work_t) const noexcept
+   {
+      using asio::execution::outstanding_work;
+      return tracked_ ? asio::execution::outstanding_work_t(outstanding_work.tracked)
+                      : asio::execution::outstanding_work_t(outstanding_work.untracked);
+   }
+
+   executor_type require(asio::execution::blocking_t::never_t) const noexcept
+   {
+      return executor_type(pool_, tracked_, false);
+   }
+
+   executor_type require(asio::execution::blocking_t::possibly_t) const noexcept
+   {
+      return executor_type(pool_, tracked_, true);
+   }
+
+   executor_type require(asio::execution::outstanding_work_t::tracked_t) const noexcept
+   {
+      return executor_type(pool_, true, possibly_);
+   }
+
+   executor_type require(asio::execution::outstanding_work_t::untracked_t) const noexcept
+   {
+      return executor_type(pool_, false, possibly_);
+   }
+
+   template <typename F>
+   void execute(F&& f) const
+   {
+      if (possibly_ && pool_->running_in_this_thread())
+      {
+         std::decay_t<F> function(std::forward<F>(f));
+         function();
+      }
+      else
+         pool_->submit(Task(std::forward<F>(f)));
+   }
+
+   bool running_in_this_thread() const noexcept { return pool_->running_in_this_thread(); }
+
+   friend bool operator==(const executor_type& a, const executor_type& b) noexcept
+   {
+      return a.pool_ == b.pool_ && a.tracked_ == b.tracked_ && a.possibly_ == b.possibly_;
+   }
+
+private:
+   friend class WorkStealingPool;
+
+   executor_type(WorkStealingPool* pool, bool tracked, bool possibly) noexcept
+      : pool_(pool), tracked_(tracked), possibly_(possibly)
+   {
+      if (tracked_)
+         pool_->work_started();
+   }
+
+   WorkStealingPool* pool_;
+   bool tracked_;
+   bool possibly_;
+};
+
+// -------------------------------------------------------------------------------------------------
+
+inline WorkStealingPool::executor_type WorkStealingPool::get_executor() noexcept
+{
+   return executor_type(this, false, false);
+}
+
+// =================================================================================================
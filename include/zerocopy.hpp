@@ -0,0 +1,198 @@
+#pragma once
+#include "splice.hpp" // asio_coro_detail::throw_errno()
+
+#include <boost/asio/as_tuple.hpp>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/deferred.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/this_coro.hpp>
+
+#include <concepts>
+#include <cstring>
+#include <exception>
+
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+namespace asio = boost::asio; // NOLINT(misc-unused-alias-decls)
+
+// =================================================================================================
+
+/**
+ * A socket that can send with MSG_ZEROCOPY: it must expose its descriptor and support waiting for
+ * both writability and pending errors, like \c tcp::socket.
+ */
+template <typename T>
+concept ZerocopyStream = requires(T& stream) {
+   { stream.native_handle() } -> std::convertible_to<int>;
+   stream.native_non_blocking(true);
+   stream.async_wait(T::wait_write, asio::deferred);
+   stream.async_wait(T::wait_error, asio::deferred);
+};
+
+/**
+ * Enables MSG_ZEROCOPY on \p stream. Returns false if the kernel or the socket type doesn't
+ * support it, in which case a regular write should be used instead.
+ */
+template <ZerocopyStream Stream>
+bool enable_zerocopy(Stream& stream)
+{
+   int one = 1;
+   return ::setsockopt(stream.native_handle(), SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+namespace asio_coro_detail
+{
+/**
+ * Keeps track of the sends that the kernel still references. Every successful send() with
+ * MSG_ZEROCOPY is eventually released by a notification on the error queue of the socket. The
+ * kernel coalesces notifications into ranges of consecutive sends.
+ */
+class ZerocopyNotifications
+{
+public:
+   explicit ZerocopyNotifications(int fd) : fd_(fd) {}
+
+   void sent() noexcept { ++sent_; }
+   bool pending() const noexcept { return released_ < sent_; }
+   size_t released() const noexcept { return released_; }
+
+   /// Reads all notifications currently queued, without blocking.
+   void read()
+   {
+      for (;;)
+      {
+         char control[128];
+         msghdr msg{};
+         msg.msg_control = control;
+         msg.msg_controllen = sizeof(control);
+         if (::recvmsg(fd_, &msg, MSG_ERRQUEUE) < 0)
+         {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+               return;
+            throw_errno("recvmsg (MSG_ERRQUEUE)");
+         }
+
+         for (auto* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+         {
+            if (!(cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_RECVERR) &&
+                !(cmsg->cmsg_level == SOL_IPV6 && cmsg->cmsg_type == IPV6_RECVERR))
+               continue;
+
+            sock_extended_err error;
+            std::memcpy(&error, CMSG_DATA(cmsg), sizeof(error));
+            if (error.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            {
+               errno = int(error.ee_errno);
+               throw_errno("MSG_ZEROCOPY");
+            }
+
+            released_ += error.ee_data - error.ee_info + 1; // range [ee_info, ee_data]
+         }
+      }
+   }
+
+private:
+   int fd_;
+   size_t sent_ = 0;
+   size_t released_ = 0;
+};
+
+/**
+ * Reads the notifications, waiting for the error queue until at least one more send is released.
+ *
+ * With epoll, Asio waits for \c wait_error edge triggered: A notification signalled before the
+ * wait started doesn't complete it. So the queue is drained right before each wait. A
+ * notification arriving later is queued anew and signalled again. The reactor runs only between
+ * handlers on the context's thread, so it can't consume that signal before the wait has started,
+ * given one thread per IO context.
+ *
+ * Cancellation doesn't stop the wait, the kernel may still be reading from the memory.
+ */
+template <ZerocopyStream Stream>
+asio::awaitable<void> wait_for_notifications(Stream& stream, ZerocopyNotifications& notifications)
+{
+   auto released = notifications.released();
+   notifications.read();
+   while (notifications.released() == released)
+   {
+      co_await stream.async_wait(Stream::wait_error, asio::as_tuple(asio::deferred));
+      notifications.read();
+   }
+}
+} // namespace asio_coro_detail
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Sends \p data with MSG_ZEROCOPY, letting the NIC read directly from user memory instead of the
+ * kernel copying it into socket buffers. Zerocopy must have been enabled with \c enable_zerocopy().
+ *
+ * Completes only after the kernel has released all of \p data, so the caller may reuse or free
+ * the memory afterwards. This holds on cancellation and errors as well. Like \c write() in
+ * stream_utils.hpp, cancellation is not an error, but returns the number of bytes sent so far.
+ *
+ * Pinning pages and processing notifications has a cost of its own. It pays off only for large
+ * writes (tens of KiB and more) over real network interfaces. On loopback, the kernel copies
+ * anyway (reported as SO_EE_CODE_ZEROCOPY_COPIED, which is ignored here).
+ */
+template <ZerocopyStream Stream>
+asio::awaitable<size_t> send_zerocopy(Stream& stream, asio::const_buffer data)
+{
+   stream.native_non_blocking(true);
+   asio_coro_detail::ZerocopyNotifications notifications(stream.native_handle());
+
+   size_t total = 0;
+   std::exception_ptr error;
+   try
+   {
+      while (total < data.size())
+      {
+         auto* begin = static_cast<const char*>(data.data()) + total;
+         auto n = ::send(stream.native_handle(), begin, data.size() - total,
+                         MSG_ZEROCOPY | MSG_NOSIGNAL);
+         if (n >= 0)
+         {
+            total += size_t(n);
+            notifications.sent();
+         }
+         else if (errno == EAGAIN)
+            co_await stream.async_wait(Stream::wait_write, asio::deferred);
+         else if (errno == ENOBUFS && notifications.pending()) // too many pages pinned (optmem)
+            co_await asio_coro_detail::wait_for_notifications(stream, notifications);
+         else
+            asio_coro_detail::throw_errno("send (MSG_ZEROCOPY)");
+
+         notifications.read();
+      }
+   }
+   catch (const boost::system::system_error& ex)
+   {
+      if (ex.code() != asio::error::operation_aborted)
+         error = std::current_exception();
+   }
+   catch (...)
+   {
+      error = std::current_exception();
+   }
+
+   //
+   // Even if cancelled, the memory must not be handed back to the caller while the kernel is
+   // still reading from it.
+   //
+   auto throw_if_cancelled = co_await asio::this_coro::throw_if_cancelled();
+   co_await asio::this_coro::throw_if_cancelled(false);
+   while (notifications.pending())
+      co_await asio_coro_detail::wait_for_notifications(stream, notifications);
+   co_await asio::this_coro::throw_if_cancelled(throw_if_cancelled);
+
+   if (error)
+      std::rethrow_exception(error);
+   co_return total;
+}
+
+// =================================================================================================
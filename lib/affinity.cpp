@@ -0,0 +1,102 @@
+#include "affinity.hpp"
+
+#include <boost/system/system_error.hpp>
+
+#include <algorithm>
+#include <charconv>
+#include <filesystem>
+#include <format>
+#include <ranges>
+#include <stdexcept>
+
+#include <pthread.h>
+#include <sched.h>
+
+// =================================================================================================
+
+std::vector<unsigned> parse_cpu_list(std::string_view list)
+{
+   auto to_number = [list](std::string_view text)
+   {
+      unsigned cpu = 0;
+      auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), cpu);
+      if (ec != std::errc{} || end != text.data() + text.size() || cpu >= CPU_SETSIZE)
+         throw std::invalid_argument(std::format("invalid CPU list '{}'", list));
+      return cpu;
+   };
+
+   std::vector<unsigned> cpus;
+   for (auto range : list | std::views::split(','))
+   {
+      auto item = std::string_view(range);
+      if (auto dash = item.find('-'); dash == std::string_view::npos)
+         cpus.push_back(to_number(item));
+      else
+      {
+         auto first = to_number(item.substr(0, dash));
+         auto last = to_number(item.substr(dash + 1));
+         if (first > last)
+            throw std::invalid_argument(std::format("invalid CPU range '{}'", item));
+         for (auto cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+      }
+   }
+   return cpus;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+std::vector<unsigned> available_cpus()
+{
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   if (sched_getaffinity(0, sizeof(set), &set) != 0)
+      throw boost::system::system_error(errno, boost::system::system_category(),
+                                        "sched_getaffinity");
+
+   std::vector<unsigned> cpus;
+   for (unsigned cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+      if (CPU_ISSET(cpu, &set))
+         cpus.push_back(cpu);
+   return cpus;
+}
+
+void check_cpus_available(const std::vector<unsigned>& cpus)
+{
+   auto available = available_cpus();
+   for (auto cpu : cpus)
+      if (!std::ranges::binary_search(available, cpu))
+         throw std::invalid_argument(std::format("CPU {} is not available", cpu));
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/// The sysfs directory of each CPU contains a 'nodeN' link to the NUMA node it belongs to.
+int numa_node(unsigned cpu)
+{
+   std::error_code ec;
+   auto path = std::filesystem::path(std::format("/sys/devices/system/cpu/cpu{}", cpu));
+   for (const auto& entry : std::filesystem::directory_iterator(path, ec))
+   {
+      auto name = entry.path().filename().native();
+      int node = 0;
+      if (name.starts_with("node") &&
+          std::from_chars(name.data() + 4, name.data() + name.size(), node).ec == std::errc{})
+         return node;
+   }
+   return -1;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+void pin_this_thread(unsigned cpu)
+{
+   cpu_set_t set;
+   CPU_ZERO(&set);
+   CPU_SET(cpu, &set);
+   if (auto rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); rc != 0)
+      throw boost::system::system_error(rc, boost::system::system_category(),
+                                        std::format("pinning thread to CPU {}", cpu));
+}
+
+// =================================================================================================
@@ -0,0 +1,95 @@
+#include "benchmark_result.hpp"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <stdexcept>
+
+// =================================================================================================
+
+namespace
+{
+std::string quoted(std::string_view text)
+{
+   std::string result = "\"";
+   for (char c : text)
+   {
+      if (c == '"' || c == '\\')
+         std::format_to(std::back_inserter(result), "\\{}", c);
+      else if (static_cast<unsigned char>(c) < 0x20)
+         std::format_to(std::back_inserter(result), "\\u{:04x}", unsigned(c));
+      else
+         result += c;
+   }
+   return result + '"';
+}
+
+void format_latency(std::back_insert_iterator<std::string> out,
+                    const std::optional<Histogram>& latency)
+{
+   if (!latency || latency->count() == 0)
+   {
+      std::format_to(out, "null");
+      return;
+   }
+
+   std::format_to(out, R"({{"count":{},"min":{},"mean":{:.0f},)", latency->count(), latency->min(),
+                  latency->mean());
+   for (auto [name, p] : {std::pair{"p50", 50.0}, {"p90", 90.0}, {"p99", 99.0}, {"p99.9", 99.9}})
+      std::format_to(out, R"("{}":{},)", name, latency->percentile(p));
+   std::format_to(out, R"("max":{}}})", latency->max());
+}
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+
+std::string to_json(const BenchmarkResult& result)
+{
+   std::string json;
+   auto out = std::back_inserter(json);
+
+   std::format_to(out, R"({{"client":{},"mode":{},"config":{{)", quoted(result.client),
+                  quoted(result.mode));
+   std::format_to(out, R"("host":{},"port":{},"connections":{},"threads":{},"duration":{},)",
+                  quoted(result.host), result.port, result.connections, result.threads,
+                  result.duration);
+   std::format_to(out, R"("buffer_size":{},"message_size":{},"rate":)", result.buffer_size,
+                  result.message_size);
+   if (result.rate)
+      std::format_to(out, "{}}},", *result.rate);
+   else
+      std::format_to(out, "null}},");
+
+   auto total = std::accumulate(result.bytes.begin(), result.bytes.end(), size_t{0});
+   auto ms = std::max<int64_t>(result.elapsed.count(), 1);
+   auto mib_per_s = double(total) * 1000.0 / 1024.0 / 1024.0 / double(ms);
+   std::format_to(out, R"("bytes":[{:n}],"total_bytes":{},"elapsed_ms":{},)", result.bytes, total,
+                  ms);
+   std::format_to(out, R"("throughput_mib_s":{:.1f},)", mib_per_s);
+
+   json += R"("latency_ns":)";
+   format_latency(out, result.latency);
+   if (result.connect_latency)
+   {
+      auto connects = result.connect_latency->count();
+      std::format_to(out, R"(,"connects":{},"connects_per_s":{:.1f},"connect_latency_ns":)",
+                     connects, double(connects) * 1000.0 / double(ms));
+      format_latency(out, result.connect_latency);
+   }
+   return json + "}";
+}
+
+// -------------------------------------------------------------------------------------------------
+
+void write_json(std::span<const BenchmarkResult> results, const std::string& path)
+{
+   std::ofstream file(path);
+   if (!file)
+      throw std::runtime_error(std::format("cannot open '{}' for writing", path));
+   for (const auto& result : results)
+      file << to_json(result) << '\n';
+}
+
+// =================================================================================================
@@ -0,0 +1,129 @@
+#include "instrumented_runner.hpp"
+
+#include <algorithm>
+#include <ctime>
+
+// =================================================================================================
+
+namespace
+{
+using std::chrono::nanoseconds;
+using std::chrono::steady_clock;
+
+/// CPU time consumed by the calling thread, which doesn't advance while it is blocked.
+nanoseconds thread_cpu_time()
+{
+   timespec ts;
+   ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+   return std::chrono::seconds(ts.tv_sec) + nanoseconds(ts.tv_nsec);
+}
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+
+void InstrumentedRunner::ThreadStats::merge(const ThreadStats& other)
+{
+   handlers += other.handlers;
+   busy += other.busy;
+   idle += other.idle;
+   handler_time.merge(other.handler_time);
+   batch_size.merge(other.batch_size);
+}
+
+double InstrumentedRunner::ThreadStats::busy_ratio() const
+{
+   auto total = busy + idle;
+   return total.count() ? double(busy.count()) / double(total.count()) : 0.0;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+size_t InstrumentedRunner::run(boost::asio::io_context& context)
+{
+   auto& slot = add_slot();
+   ThreadStats stats;
+   auto publish = [&]
+   {
+      std::lock_guard lock(slot.mutex);
+      slot.stats = stats;
+   };
+
+   size_t total = 0;
+   uint64_t batch = 0;
+   auto published = steady_clock::now();
+   for (;;)
+   {
+      //
+      // Execute everything that is ready, without blocking.
+      //
+      auto start = steady_clock::now();
+      for (auto t0 = start; context.poll_one();)
+      {
+         auto t1 = steady_clock::now();
+         stats.handler_time.record(t1 - t0);
+         t0 = t1;
+         ++batch;
+      }
+      auto now = steady_clock::now();
+      stats.busy += now - start;
+
+      if (batch)
+      {
+         stats.handlers += batch;
+         stats.batch_size.record(batch);
+         total += batch;
+         batch = 0;
+      }
+
+      if (now - published >= publish_interval)
+      {
+         publish();
+         published = now;
+      }
+
+      if (context.stopped())
+         break;
+
+      //
+      // Nothing to do, so block until the next handler is ready and has been executed.
+      //
+      auto cpu0 = thread_cpu_time();
+      auto n = context.run_one();
+      auto cpu = thread_cpu_time() - cpu0;
+      auto wall = steady_clock::now() - now;
+
+      stats.busy += cpu;
+      stats.idle += std::max(nanoseconds(wall - cpu), nanoseconds(0));
+      if (n == 0)
+         break;
+
+      stats.handler_time.record(cpu);
+      batch = 1;
+   }
+
+   publish();
+   return total;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+InstrumentedRunner::Snapshot InstrumentedRunner::snapshot() const
+{
+   Snapshot snapshot;
+   std::lock_guard lock(mutex_);
+   for (const auto& slot : slots_)
+   {
+      std::lock_guard slot_lock(slot->mutex);
+      snapshot.threads.push_back(slot->stats);
+      snapshot.total.merge(slot->stats);
+   }
+   return snapshot;
+}
+
+InstrumentedRunner::Slot& InstrumentedRunner::add_slot()
+{
+   std::lock_guard lock(mutex_);
+   return *slots_.emplace_back(std::make_unique<Slot>());
+}
+
+// =================================================================================================
@@ -1,10 +1,13 @@
 #include "program_options.hpp"
 
+#include "affinity.hpp"
+#include "instrumented_runner.hpp"
 #include "run.hpp"
 
 #include <boost/asio.hpp>
 #include <boost/program_options.hpp>
 
+#include <condition_variable>
 #include <iostream>
 #include <thread>
 #include <vector>
@@ -18,11 +21,55 @@ size_t get_terminal_width(size_t fallback = 80)
    return fallback;
 }
 
+/**
+ * Prints a one line summary of the runtime metrics. Handler rate and busy ratios are relative to
+ * the \p previous snapshot, taken \p dt earlier, the histograms cover the whole runtime.
+ */
+void print_metrics(const InstrumentedRunner::Snapshot& current,
+                   const InstrumentedRunner::Snapshot& previous, std::chrono::duration<double> dt)
+{
+   auto busy_ratio = [](const InstrumentedRunner::ThreadStats& stats,
+                        const InstrumentedRunner::ThreadStats* before)
+   {
+      if (!before)
+         return stats.busy_ratio();
+      auto busy = stats.busy - before->busy;
+      auto total = busy + stats.idle - before->idle;
+      return total.count() ? double(busy.count()) / double(total.count()) : 0.0;
+   };
+
+   std::string threads;
+   for (std::size_t i = 0; i < current.threads.size(); ++i)
+   {
+      const auto* before = i < previous.threads.size() ? &previous.threads[i] : nullptr;
+      threads += std::format(" {:.0f}%", busy_ratio(current.threads[i], before) * 100);
+   }
+
+   const auto& batch = current.total.batch_size;
+   std::println("metrics: {:.0f} handlers/s, busy {:.0f}% ({} ), handler time {}, batch size "
+                "p50={} p99={} max={}",
+                double(current.total.handlers - previous.total.handlers) / dt.count(),
+                busy_ratio(current.total, &previous.total) * 100, threads.substr(1),
+                current.total.handler_time, batch.percentile(50), batch.percentile(99),
+                batch.max());
+}
+
+// -------------------------------------------------------------------------------------------------
+
 int run(boost::asio::io_context& context, int argc, char* argv[])
+{
+   return run(context, argc, argv, {});
+}
+
+int run(boost::asio::io_context& context, int argc, char* argv[],
+        const boost::program_options::options_description& options)
 {
    namespace po = boost::program_options;
    bool debug = false;
+   bool pin = false;
+   std::string cpu_list;
    std::size_t threads = 0;
+   double metrics = 0;
 
    po::options_description desc("Usage", get_terminal_width(120));
    desc.add_options() //
@@ -30,7 +77,15 @@ int run(boost::asio::io_context& context, int argc, char* argv[])
       ("debug,d", po::bool_switch(&debug)->default_value(debug),
        "use debug run() for io_context (noisy, for testing only)") //
       ("threads,t", po::value<std::size_t>(&threads)->default_value(threads)->value_name("N"),
-       "number of extra threads that should run the io_context");
+       "number of extra threads that should run the io_context") //
+      ("pin", po::bool_switch(&pin)->default_value(pin),
+       "pin each thread running the io_context to one of the available CPUs") //
+      ("cpus", po::value<std::string>(&cpu_list)->value_name("LIST"),
+       "pin threads to the CPUs in LIST, like '0-3,8' (implies --pin)") //
+      ("metrics", po::value<double>(&metrics)->value_name("SECONDS"),
+       "print handler rate, busy ratio per thread and handler times every SECONDS");
+   if (!options.options().empty())
+      desc.add(options);
 
    po::variables_map vm;
    try
@@ -56,24 +111,104 @@ int run(boost::asio::io_context& context, int argc, char* argv[])
       return 1;
    }
 
+   if (debug && metrics > 0)
+   {
+      std::println(std::cerr, "ERROR: --debug and --metrics are mutually exclusive");
+      return 1;
+   }
+
+   //
+   // Thread 'i' is pinned to CPU 'cpus[i % cpus.size()]', with the calling thread being number 0.
+   //
+   std::vector<unsigned> cpus;
+   try
+   {
+      if (!cpu_list.empty())
+      {
+         cpus = parse_cpu_list(cpu_list);
+         check_cpus_available(cpus); // before starting threads, pinning them must not fail
+      }
+      else if (pin)
+         cpus = available_cpus();
+   }
+   catch (const std::exception& ex)
+   {
+      std::println(std::cerr, "ERROR: {}", ex.what());
+      return 1;
+   }
+
+   auto pin_thread = [&cpus](std::size_t i)
+   {
+      if (cpus.empty())
+         return;
+      auto cpu = cpus[i % cpus.size()];
+      pin_this_thread(cpu);
+      std::println("thread {} pinned to CPU {} (NUMA node {})", i, cpu, numa_node(cpu));
+   };
+
    //
    // finally, run IO context
    //
+   pin_thread(0);
    if (debug)
    {
       ::runDebug(context);
    }
    else
    {
+      InstrumentedRunner runner;
+      auto run_context = [&]()
+      {
+         if (metrics > 0)
+            runner.run(context);
+         else
+            context.run();
+      };
+
+      //
+      // With --metrics, a separate thread reports periodically until the IO context has stopped.
+      //
+      std::jthread reporter;
+      if (metrics > 0)
+         reporter = std::jthread([&runner, metrics](std::stop_token stop)
+         {
+            std::mutex mutex;
+            std::condition_variable_any cv;
+            std::unique_lock lock(mutex);
+
+            auto interval = std::chrono::duration<double>(metrics);
+            auto previous = runner.snapshot();
+            while (!cv.wait_for(lock, stop, interval, [] { return false; }) &&
+                   !stop.stop_requested())
+            {
+               auto current = runner.snapshot();
+               print_metrics(current, previous, interval);
+               previous = std::move(current);
+            }
+         });
+
       std::vector<std::jthread> workers;
       workers.reserve(threads);
       for (std::size_t i = 0; i < threads; ++i)
-         workers.emplace_back([&context]() { context.run(); });
+         workers.emplace_back([&run_context, &pin_thread, i]()
+         {
+            pin_thread(i + 1);
+            run_context();
+         });
 
-      context.run();
+      run_context();
 
       for (auto& thread : workers)
          thread.join();
+
+      if (reporter.joinable())
+      {
+         reporter.request_stop();
+         reporter.join();
+         auto total = runner.snapshot().total;
+         std::println("metrics: {} handlers in total, busy {:.0f}%, handler time {}",
+                      total.handlers, total.busy_ratio() * 100, total.handler_time);
+      }
    }
 
    return 0;
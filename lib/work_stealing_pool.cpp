@@ -0,0 +1,226 @@
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <functional>
+#include <optional>
+
+// =================================================================================================
+
+namespace
+{
+/// The pool and queue of the worker running on this thread, if any.
+struct CurrentWorker
+{
+   const WorkStealingPool* pool = nullptr;
+   std::size_t index = 0;
+};
+
+thread_local CurrentWorker current_worker;
+} // namespace
+
+// -------------------------------------------------------------------------------------------------
+
+WorkStealingPool::WorkStealingPool(std::size_t threads)
+{
+   threads = std::max<std::size_t>(threads, 1);
+   for (std::size_t i = 0; i < threads; ++i)
+      workers_.push_back(std::make_unique<Worker>());
+
+   threads_.reserve(threads);
+   for (std::size_t i = 0; i < threads; ++i)
+      threads_.emplace_back([this, i] { run(i); });
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+   stop();
+   for (auto& thread : threads_)
+      if (thread.joinable())
+         thread.join();
+
+   shutdown();
+
+   //
+   // Destroying a task may destroy a coroutine frame, which in turn may submit another task.
+   //
+   for (bool empty = false; !empty;)
+   {
+      empty = true;
+      for (auto& worker : workers_)
+      {
+         std::deque<Task> tasks;
+         {
+            std::lock_guard lock(worker->mutex);
+            tasks.swap(worker->tasks);
+         }
+         empty = empty && tasks.empty();
+      }
+   }
+
+   destroy();
+}
+
+// -------------------------------------------------------------------------------------------------
+
+void WorkStealingPool::join()
+{
+   assert(!running_in_this_thread() && "join() would wait for itself");
+   joining_.store(true, std::memory_order_seq_cst);
+   wake_all();
+   for (auto& thread : threads_)
+      if (thread.joinable())
+         thread.join();
+}
+
+void WorkStealingPool::stop()
+{
+   stopped_.store(true, std::memory_order_seq_cst);
+   wake_all();
+}
+
+bool WorkStealingPool::running_in_this_thread() const noexcept
+{
+   return current_worker.pool == this;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+void WorkStealingPool::submit(Task task)
+{
+   work_started();
+
+   // round-robin for submissions from outside, starting at different workers for each thread
+   static thread_local std::size_t next = std::hash<std::thread::id>{}(std::this_thread::get_id());
+   auto index = running_in_this_thread() ? current_worker.index : next++ % workers_.size();
+
+   //
+   // Pairs with the sleeping worker in run(): Either the worker sees the new task when checking
+   // after announcing that it is going to sleep, or this thread sees the announcement. Reading
+   // the number of sleepers doesn't write to its cache line, which stays shared while busy.
+   //
+   {
+      auto& worker = *workers_[index];
+      std::lock_guard lock(worker.mutex);
+      worker.tasks.push_back(std::move(task));
+      worker.queued.store(worker.tasks.size(), std::memory_order_seq_cst);
+   }
+   if (sleepers_.load(std::memory_order_seq_cst) > 0)
+   {
+      { std::lock_guard lock(sleep_mutex_); }
+      sleep_cv_.notify_one();
+   }
+}
+
+/**
+ * Runs a single task, taken from the back of the worker's own queue or, if that is empty, from
+ * the front of the queue of another worker. Returns false if no task has been found.
+ */
+bool WorkStealingPool::try_run(std::size_t index)
+{
+   auto pop = [this](std::size_t i, bool back) -> std::optional<Task>
+   {
+      auto& worker = *workers_[i];
+      std::lock_guard lock(worker.mutex);
+      if (worker.tasks.empty())
+         return std::nullopt;
+
+      std::optional<Task> task;
+      if (back)
+      {
+         task.emplace(std::move(worker.tasks.back()));
+         worker.tasks.pop_back();
+      }
+      else
+      {
+         task.emplace(std::move(worker.tasks.front()));
+         worker.tasks.pop_front();
+      }
+      worker.queued.store(worker.tasks.size(), std::memory_order_relaxed);
+      return task;
+   };
+
+   auto task = pop(index, true);
+   for (std::size_t i = 1; !task && i < workers_.size(); ++i)
+      task = pop((index + i) % workers_.size(), false);
+
+   if (!task)
+      return false;
+
+   (*task)();
+   work_finished();
+   return true;
+}
+
+void WorkStealingPool::run(std::size_t index)
+{
+   current_worker = {this, index};
+   while (!stopped_.load(std::memory_order_relaxed))
+   {
+      if (try_run(index))
+         continue;
+
+      std::unique_lock lock(sleep_mutex_);
+      sleepers_.fetch_add(1, std::memory_order_seq_cst);
+      sleep_cv_.wait(lock, [this]
+      {
+         return any_queued() || stopped_.load() || (joining_.load() && outstanding() == 0);
+      });
+      sleepers_.fetch_sub(1, std::memory_order_relaxed);
+
+      if (joining_.load() && outstanding() == 0)
+         break;
+   }
+   current_worker = {};
+}
+
+// -------------------------------------------------------------------------------------------------
+
+void WorkStealingPool::work_started() noexcept
+{
+   work_counts().started.fetch_add(1, std::memory_order_relaxed);
+}
+
+void WorkStealingPool::work_finished() noexcept
+{
+   work_counts().finished.fetch_add(1, std::memory_order_seq_cst);
+   if (joining_.load(std::memory_order_seq_cst) && outstanding() == 0)
+      wake_all();
+}
+
+/// The counts of the calling thread: of its worker, or the shared ones for outside threads.
+WorkStealingPool::WorkCounts& WorkStealingPool::work_counts() noexcept
+{
+   return running_in_this_thread() ? workers_[current_worker.index]->work : external_;
+}
+
+/**
+ * Returns the number of queued and running tasks plus tracked executors. Finishing work happens
+ * after starting it, so reading all the finished counts before the started ones never yields a
+ * count below the actual one, even while tasks are still submitting others.
+ */
+std::size_t WorkStealingPool::outstanding() const noexcept
+{
+   std::size_t finished = external_.finished.load(std::memory_order_seq_cst);
+   for (const auto& worker : workers_)
+      finished += worker->work.finished.load(std::memory_order_seq_cst);
+
+   std::size_t started = external_.started.load(std::memory_order_seq_cst);
+   for (const auto& worker : workers_)
+      started += worker->work.started.load(std::memory_order_seq_cst);
+   return started - finished;
+}
+
+bool WorkStealingPool::any_queued() const noexcept
+{
+   return std::ranges::any_of(workers_, [](const auto& worker)
+   { return worker->queued.load(std::memory_order_seq_cst) > 0; });
+}
+
+void WorkStealingPool::wake_all()
+{
+   { std::lock_guard lock(sleep_mutex_); }
+   sleep_cv_.notify_all();
+}
+
+// =================================================================================================
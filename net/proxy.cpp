@@ -1,4 +1,5 @@
 #include "formatters.hpp"
+#include "stream_utils.hpp"
 
 #include <boost/asio.hpp>
 #include <boost/asio/experimental/awaitable_operators.hpp>
@@ -7,26 +8,10 @@ using namespace boost::asio;
 using namespace experimental::awaitable_operators;
 using ip::tcp;
 
+/// Relays from one socket to the other, using splice(2) to avoid copying through user space.
 awaitable<size_t> forward(tcp::socket& from, tcp::socket& to)
 {
-   size_t total = 0;
-
-   try
-   {
-      std::array<char, 64 * 1024> data;
-      for (;;)
-      {
-         auto n = co_await from.async_read_some(buffer(data));
-         total += n;
-         co_await async_write(to, buffer(data, n));
-      }
-   }
-   catch (boost::system::system_error& ex)
-   {
-      if (ex.code() != error::eof)
-         throw;
-   }
-
+   auto total = co_await relay(from, to);
    to.shutdown(tcp::socket::shutdown_send);
    co_return total;
 }
@@ -4,6 +4,8 @@
 
 #include <gtest/gtest.h>
 
+#include <numeric>
+#include <ranges>
 #include <thread>
 
 using namespace asio;
@@ -188,6 +190,130 @@ TEST_F(AsyncInvoke, WHEN_async_invoke_without_token_THEN_uses_default_token)
 
 // -------------------------------------------------------------------------------------------------
 
+TEST_F(AsyncInvoke, WHEN_bulk_THEN_completes_once_with_results_in_order)
+{
+   std::vector<int> inputs(10'000);
+   std::iota(inputs.begin(), inputs.end(), 0);
+   size_t completions = 0;
+   std::vector<int> results;
+   async_invoke_bulk(pool, bind_executor(executor, [&](std::exception_ptr ex, std::vector<int> r)
+   {
+      EXPECT_FALSE(ex);
+      results = std::move(r);
+      completions++;
+   }), inputs, [](int i) { return i * 2; });
+   run();
+   EXPECT_EQ(completions, 1);
+   ASSERT_EQ(results.size(), inputs.size());
+   for (size_t i = 0; i < results.size(); ++i)
+      EXPECT_EQ(results[i], inputs[i] * 2);
+}
+
+TEST_F(AsyncInvoke, WHEN_bulk_without_inputs_THEN_completes_with_empty_vector)
+{
+   std::optional<std::vector<int>> results;
+   async_invoke_bulk(pool, bind_executor(executor, [&](std::exception_ptr, std::vector<int> r)
+   { results = std::move(r); }), std::vector<int>{}, [](int i) { return i; });
+   run();
+   ASSERT_TRUE(results);
+   EXPECT_TRUE(results->empty());
+}
+
+TEST_F(AsyncInvoke, WHEN_bulk_throws_THEN_completes_with_exception)
+{
+   std::exception_ptr error;
+   co_spawn(executor, [&] -> awaitable<void>
+   {
+      auto [ex, results] = co_await async_invoke_bulk(pool, as_tuple(deferred),
+                                                      std::views::iota(0, 1000), [](int i)
+      {
+         if (i == 500)
+            throw std::runtime_error("invalid");
+         return i;
+      });
+      EXPECT_TRUE(results.empty());
+      error = ex;
+   }, detached);
+   run();
+   EXPECT_THROW(std::rethrow_exception(error), std::runtime_error);
+}
+
+TEST_F(AsyncInvoke, WHEN_bulk_cancelled_THEN_completes_with_operation_aborted)
+{
+   std::atomic<size_t> count = 0;
+   std::exception_ptr error;
+   co_spawn(executor, [&] -> awaitable<void>
+   {
+      auto [ex, results] = co_await async_invoke_bulk(
+         pool, cancel_after(50ms, as_tuple(deferred)), std::vector<Duration>(1000, 10ms),
+         [&](Duration d)
+      {
+         std::this_thread::sleep_for(d);
+         return ++count;
+      });
+      error = ex;
+   }, detached);
+   run();
+   EXPECT_LT(count, 1000);
+   ASSERT_TRUE(error);
+   try
+   {
+      std::rethrow_exception(error);
+   }
+   catch (const system_error& ex)
+   {
+      EXPECT_EQ(ex.code(), asio::error::operation_aborted);
+   }
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * With all pool threads busy, the callables are still queued when the timeout fires. They are
+ * dropped without ever running.
+ */
+TEST_F(AsyncInvoke, WHEN_cancelled_while_queued_THEN_callable_does_not_run)
+{
+   std::atomic<size_t> started = 0;
+   size_t aborted = 0;
+   for (size_t i = 0; i < 20; ++i)
+      co_spawn(executor, [&] -> awaitable<void>
+      {
+         auto [ex, result] = co_await async_invoke_cancellable(
+            pool, cancel_after(50ms, as_tuple(deferred)), [&]
+         {
+            ++started;
+            std::this_thread::sleep_for(200ms);
+            return 1;
+         });
+         if (ex)
+            aborted++;
+      }, detached);
+   run();
+   EXPECT_EQ(started, 10); // one per pool thread
+   EXPECT_EQ(aborted, 10);
+}
+
+TEST_F(AsyncInvoke, WHEN_cancelled_while_running_THEN_stop_is_requested)
+{
+   co_spawn(executor, [&] -> awaitable<void>
+   {
+      auto result = co_await async_invoke_cancellable(
+         pool, cancel_after(50ms, deferred), [](std::stop_token stop, Duration step)
+      {
+         size_t steps = 0;
+         for (; !stop.stop_requested(); ++steps)
+            std::this_thread::sleep_for(step);
+         return steps;
+      }, 1ms);
+      EXPECT_GT(result, 0);
+      EXPECT_LT(result, 1000);
+   }, detached);
+   run();
+}
+
+// -------------------------------------------------------------------------------------------------
+
 /// This has ~30% TSAN failure with libc++, possibly because of missing TSAN instrumentation.
 TEST_F(AsyncInvoke, DISABLED_WHEN_job_returns_error_THEN_is_thrown_by_future)
 {
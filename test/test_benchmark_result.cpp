@@ -0,0 +1,62 @@
+#include "benchmark_result.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+// =================================================================================================
+
+TEST(BenchmarkResult, WHEN_throughput_THEN_latency_is_null)
+{
+   BenchmarkResult result{.client = "client",
+                          .mode = "throughput",
+                          .host = "127.0.0.1",
+                          .port = 55555,
+                          .connections = 2,
+                          .threads = 1,
+                          .duration = 1,
+                          .buffer_size = 1024,
+                          .message_size = 64,
+                          .bytes = {1024 * 1024, 1024 * 1024},
+                          .elapsed = 1000ms};
+   EXPECT_EQ(to_json(result),
+             R"({"client":"client","mode":"throughput","config":{"host":"127.0.0.1","port":55555,)"
+             R"("connections":2,"threads":1,"duration":1,"buffer_size":1024,"message_size":64,)"
+             R"("rate":null},"bytes":[1048576, 1048576],"total_bytes":2097152,"elapsed_ms":1000,)"
+             R"("throughput_mib_s":2.0,"latency_ns":null})");
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(BenchmarkResult, WHEN_latency_recorded_THEN_percentiles_are_included)
+{
+   Histogram latency;
+   latency.record(500ns);
+   BenchmarkResult result{.host = "\"quoted\"", .rate = 100, .latency = latency};
+   auto json = to_json(result);
+   EXPECT_NE(json.find(R"("host":"\"quoted\"")"), std::string::npos) << json;
+   EXPECT_NE(json.find(R"("rate":100})"), std::string::npos) << json;
+   EXPECT_NE(json.find(R"("latency_ns":{"count":1,"min":500,"mean":500,"p50":500,)"),
+             std::string::npos)
+      << json;
+   EXPECT_NE(json.find(R"("max":500}})"), std::string::npos) << json;
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(BenchmarkResult, WHEN_churn_THEN_connects_are_included)
+{
+   Histogram connect_latency;
+   connect_latency.record(20us);
+   connect_latency.record(30us);
+   BenchmarkResult result{.mode = "churn", .elapsed = 500ms, .connect_latency = connect_latency};
+   auto json = to_json(result);
+   EXPECT_NE(json.find(R"("latency_ns":null,"connects":2,"connects_per_s":4.0,)"),
+             std::string::npos)
+      << json;
+   EXPECT_NE(json.find(R"("connect_latency_ns":{"count":2,"min":20000,)"), std::string::npos)
+      << json;
+}
+
+// =================================================================================================
@@ -0,0 +1,76 @@
+#include "buffer_pool.hpp"
+#include "asio-coro.hpp"
+#include "stream_utils.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+
+using namespace ::testing;
+
+// =================================================================================================
+
+TEST(BufferPool, WHEN_released_THEN_is_reused)
+{
+   io_context context;
+   auto& pool = BufferPool::of(context.get_executor());
+   EXPECT_EQ(pool.available(), 0);
+
+   const char* first;
+   {
+      auto buffer = pool.acquire();
+      first = buffer.data();
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) % BufferPool::alignment, 0);
+      EXPECT_EQ(buffer.buffer().size(), BufferPool::block_size);
+   }
+   EXPECT_EQ(pool.available(), 1);
+   EXPECT_EQ(pool.acquire().data(), first);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(BufferPool, WHEN_different_contexts_THEN_different_pools)
+{
+   io_context a, b;
+   any_io_executor executor = a.get_executor();
+   EXPECT_EQ(&BufferPool::of(executor), &BufferPool::of(a.get_executor()));
+   EXPECT_NE(&BufferPool::of(a.get_executor()), &BufferPool::of(b.get_executor()));
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(BufferPool, WHEN_created_with_registered_buffers_THEN_they_are_preallocated)
+{
+   io_context context;
+   auto& pool = make_service<BufferPool>(context, BufferPool::Registered{4});
+   EXPECT_EQ(pool.available(), 4);
+   {
+      std::vector<BufferPool::Buffer> buffers;
+      for (size_t i = 0; i < 5; ++i)
+         buffers.push_back(pool.acquire()); // last one is allocated on demand
+      EXPECT_EQ(pool.available(), 0);
+   }
+   EXPECT_EQ(pool.available(), 5);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(BufferPool, WHEN_cat_THEN_buffer_is_returned_to_pool)
+{
+   io_context context;
+   readable_pipe in(context), reader(context);
+   writable_pipe writer(context), out(context);
+   connect_pipe(in, writer);
+   connect_pipe(reader, out);
+
+   auto n = co_spawn(context, cat(std::move(in), std::move(out)), use_future);
+   co_spawn(context, write_and_close(std::move(writer), "Hello, World!"sv), detached);
+   auto text = co_spawn(context, read_all(std::move(reader)), use_future);
+   context.run();
+
+   EXPECT_EQ(n.get(), 13);
+   EXPECT_EQ(text.get(), "Hello, World!");
+   EXPECT_EQ(BufferPool::of(context.get_executor()).available(), 1);
+}
+
+// =================================================================================================
@@ -0,0 +1,87 @@
+#include "histogram.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+// =================================================================================================
+
+TEST(Histogram, WHEN_empty_THEN_percentiles_are_zero)
+{
+   Histogram histogram;
+   EXPECT_EQ(histogram.count(), 0);
+   EXPECT_EQ(histogram.min(), 0);
+   EXPECT_EQ(histogram.max(), 0);
+   EXPECT_EQ(histogram.percentile(50), 0);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(Histogram, WHEN_small_values_THEN_percentiles_are_exact)
+{
+   Histogram histogram;
+   for (uint64_t i = 1; i <= 50; ++i)
+      histogram.record(i);
+   EXPECT_EQ(histogram.count(), 50);
+   EXPECT_EQ(histogram.min(), 1);
+   EXPECT_EQ(histogram.max(), 50);
+   EXPECT_EQ(histogram.percentile(50), 25);
+   EXPECT_EQ(histogram.percentile(100), 50);
+   EXPECT_DOUBLE_EQ(histogram.mean(), 25.5);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(Histogram, WHEN_large_values_THEN_relative_error_is_bounded)
+{
+   Histogram histogram;
+   for (uint64_t i = 1; i <= 100'000; ++i)
+      histogram.record(std::chrono::microseconds(i));
+
+   for (double p : {50.0, 90.0, 99.0, 99.9})
+   {
+      auto expected = p / 100.0 * 100'000 * 1'000;
+      auto actual = double(histogram.percentile(p));
+      EXPECT_NEAR(actual, expected, expected / (1 << Histogram::SubBucketBits)) << "p" << p;
+   }
+   EXPECT_EQ(histogram.percentile(100), 100'000'000);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(Histogram, WHEN_value_exceeds_range_THEN_is_clamped)
+{
+   Histogram histogram;
+   histogram.record(24h);
+   EXPECT_EQ(histogram.count(), 1);
+   EXPECT_EQ(histogram.max(), (uint64_t{1} << Histogram::MaxValueBits) - 1);
+   EXPECT_EQ(histogram.percentile(50), histogram.max());
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(Histogram, WHEN_merged_THEN_contains_both)
+{
+   Histogram a, b;
+   a.record(10ms);
+   b.record(1ms);
+   b.record(100ms);
+   a.merge(b);
+   EXPECT_EQ(a.count(), 3);
+   EXPECT_EQ(a.min(), 1'000'000);
+   EXPECT_EQ(a.max(), 100'000'000);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(Histogram, Format)
+{
+   Histogram histogram;
+   histogram.record(500ns);
+   EXPECT_EQ(std::format("{}", histogram),
+             "n=1 p50=500ns p90=500ns p99=500ns p99.9=500ns max=500ns");
+   EXPECT_EQ(std::format("{}", Latency{1'500'000}), "1.5ms");
+}
+
+// =================================================================================================
@@ -0,0 +1,63 @@
+#include "instrumented_runner.hpp"
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+// =================================================================================================
+
+TEST(InstrumentedRunner, WHEN_handlers_are_posted_THEN_all_are_counted)
+{
+   boost::asio::io_context context;
+   for (int i = 0; i < 100; ++i)
+      boost::asio::post(context, [] {});
+
+   InstrumentedRunner runner;
+   EXPECT_EQ(runner.run(context), 100);
+
+   auto snapshot = runner.snapshot();
+   ASSERT_EQ(snapshot.threads.size(), 1);
+   EXPECT_EQ(snapshot.total.handlers, 100);
+   EXPECT_EQ(snapshot.total.handler_time.count(), 100);
+   EXPECT_EQ(snapshot.total.batch_size.max(), 100);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(InstrumentedRunner, WHEN_handler_blocks_THEN_is_busy)
+{
+   boost::asio::io_context context;
+   boost::asio::post(context, [] { std::this_thread::sleep_for(50ms); });
+
+   InstrumentedRunner runner;
+   runner.run(context);
+
+   auto total = runner.snapshot().total;
+   EXPECT_GE(total.handler_time.max(), 45'000'000);
+   EXPECT_GT(total.busy_ratio(), 0.9);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(InstrumentedRunner, WHEN_waiting_for_timer_THEN_is_idle)
+{
+   boost::asio::io_context context;
+   boost::asio::steady_timer timer(context, 50ms);
+   timer.async_wait([](auto) {});
+
+   InstrumentedRunner runner;
+   runner.run(context);
+
+   auto total = runner.snapshot().total;
+   EXPECT_EQ(total.handlers, 1);
+   EXPECT_GE(total.idle, 45ms);
+   EXPECT_LT(total.busy_ratio(), 0.1);
+}
+
+// =================================================================================================
@@ -0,0 +1,97 @@
+#include "asio-coro.hpp"
+#include "mpsc_channel.hpp"
+#include "run_sync.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+using namespace std::chrono_literals;
+
+// =================================================================================================
+
+TEST(MpscChannel, WHEN_full_THEN_try_send_fails)
+{
+   MpscChannel<int> channel(3);
+   ASSERT_EQ(channel.capacity(), 4);
+   for (int i = 0; i < 4; ++i)
+      EXPECT_TRUE(channel.try_send(i));
+   EXPECT_FALSE(channel.try_send(4));
+
+   for (int i = 0; i < 4; ++i)
+      EXPECT_EQ(channel.try_receive(), i);
+   EXPECT_EQ(channel.try_receive(), std::nullopt);
+   EXPECT_TRUE(channel.try_send(5));
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Several producers on a thread pool send more values than the channel can hold, so both sides
+ * have to wait for each other. Values of each producer must arrive in order.
+ */
+TEST(MpscChannel, WHEN_sending_from_multiple_threads_THEN_all_values_arrive)
+{
+   constexpr int producers = 4;
+   constexpr int count = 100'000;
+   MpscChannel<std::pair<int, int>> channel(64);
+
+   thread_pool pool(producers);
+   for (int p = 0; p < producers; ++p)
+      co_spawn(pool, [&channel, p]() -> awaitable<void>
+      {
+         for (int i = 0; i < count; ++i)
+            co_await channel.send({p, i});
+      }, detached);
+
+   auto received = run_sync([&]() -> awaitable<int>
+   {
+      std::vector<int> next(producers);
+      int n = 0;
+      for (; n < producers * count; ++n)
+      {
+         auto [p, i] = (co_await channel.receive()).value();
+         EXPECT_EQ(i, next[p]++);
+      }
+      co_return n;
+   });
+   pool.join();
+   EXPECT_EQ(received, producers * count);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(MpscChannel, WHEN_closed_THEN_remaining_values_are_received)
+{
+   MpscChannel<std::string> channel(4);
+   EXPECT_TRUE(channel.try_send(std::string("first")));
+   channel.close();
+   EXPECT_FALSE(channel.try_send(std::string("second")));
+
+   auto [first, second] = run_sync([&]() -> awaitable<std::tuple<std::optional<std::string>,
+                                                                  std::optional<std::string>>>
+   {
+      auto first = co_await channel.receive();
+      auto second = co_await channel.receive();
+      co_return std::tuple{first, second};
+   });
+   EXPECT_EQ(first, "first");
+   EXPECT_EQ(second, std::nullopt);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(MpscChannel, WHEN_receive_is_cancelled_THEN_throws)
+{
+   MpscChannel<int> channel(4);
+   EXPECT_THROW(run_sync([&]() -> awaitable<void>
+   {
+      auto ex = co_await this_coro::executor;
+      co_await co_spawn(ex, channel.receive(), cancel_after(10ms));
+   }), system_error);
+
+   // the channel is still usable afterwards
+   EXPECT_TRUE(channel.try_send(1));
+   EXPECT_EQ(run_sync(channel.receive()), 1);
+}
+
+// =================================================================================================
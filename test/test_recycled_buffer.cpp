@@ -0,0 +1,62 @@
+#include "recycled_buffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <thread>
+
+using namespace ::testing;
+
+// =================================================================================================
+
+TEST(RecycledBuffer, WHEN_released_THEN_is_reused)
+{
+   using Buffer = RecycledBuffer<1024>;
+   const char* first;
+   {
+      Buffer buffer;
+      first = buffer.data();
+      EXPECT_EQ(reinterpret_cast<std::uintptr_t>(first) % Buffer::alignment, 0);
+   }
+   EXPECT_EQ(Buffer::cached(), 1);
+
+   Buffer buffer;
+   EXPECT_EQ(buffer.data(), first);
+   EXPECT_EQ(Buffer::cached(), 0);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(RecycledBuffer, WHEN_moved_THEN_released_once)
+{
+   using Buffer = RecycledBuffer<2048>;
+   {
+      Buffer a;
+      Buffer b(std::move(a));
+      EXPECT_EQ(a.data(), nullptr);
+      EXPECT_NE(b.data(), nullptr);
+   }
+   EXPECT_EQ(Buffer::cached(), 1);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(RecycledBuffer, WHEN_cache_is_full_THEN_buffers_are_freed)
+{
+   using Buffer = RecycledBuffer<4096, 2>;
+   {
+      std::vector<Buffer> buffers(5);
+   }
+   EXPECT_EQ(Buffer::cached(), 2);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(RecycledBuffer, WHEN_used_by_other_thread_THEN_has_separate_cache)
+{
+   using Buffer = RecycledBuffer<8192>;
+   std::jthread([] { Buffer buffer; }).join();
+   EXPECT_EQ(Buffer::cached(), 0);
+}
+
+// =================================================================================================
@@ -0,0 +1,54 @@
+#include "asio-coro.hpp"
+#include "run_sync.hpp"
+#include "stream_utils.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+
+// =================================================================================================
+
+static_assert(SpliceableStream<tcp::socket>);
+static_assert(SpliceableStream<posix::stream_descriptor>);
+static_assert(!SpliceableStream<readable_pipe>);
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Relay from one TCP connection to another, like a proxy would do. The source sends 10 MiB and
+ * then shuts down, which makes the relay complete and shut down the destination as well.
+ */
+TEST(Splice, WHEN_relaying_between_sockets_THEN_all_data_arrives)
+{
+   constexpr size_t size = 10_m;
+   auto [relayed, received] = run_sync([&] -> awaitable<std::tuple<size_t, size_t>>
+   {
+      auto ex = co_await this_coro::executor;
+      tcp::acceptor acceptor(ex, {ip::address_v6::loopback(), 0});
+
+      tcp::socket source(ex), sink(ex);
+      co_await source.async_connect(acceptor.local_endpoint());
+      auto from = co_await acceptor.async_accept();
+      co_await sink.async_connect(acceptor.local_endpoint());
+      auto to = co_await acceptor.async_accept();
+
+      auto send = [&]() -> awaitable<void>
+      {
+         co_await async_write(source, buffer(std::vector<char>(size, 'x')));
+         source.shutdown(socket_base::shutdown_send);
+      };
+
+      auto forward = [&]() -> awaitable<size_t>
+      {
+         auto n = co_await splice_relay(from, to);
+         to.shutdown(socket_base::shutdown_send);
+         co_return n;
+      };
+
+      co_return co_await (send() && forward() && count(std::move(sink)));
+   });
+   EXPECT_EQ(relayed, size);
+   EXPECT_EQ(received, size);
+}
+
+// =================================================================================================
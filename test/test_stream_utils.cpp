@@ -0,0 +1,65 @@
+#include "asio-coro.hpp"
+#include "run_sync.hpp"
+#include "stream_utils.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+
+// =================================================================================================
+
+/**
+ * Echo through pipelined_relay() while the client is still sending. Small writes make the reader
+ * run ahead of the writer, so several buffers get coalesced into one vectored write.
+ */
+TEST(StreamUtils, WHEN_pipelined_echo_THEN_all_data_is_returned)
+{
+   constexpr size_t size = 1_m;
+   auto [sent, echoed, received] = run_sync([&] -> awaitable<std::tuple<size_t, size_t, size_t>>
+   {
+      auto ex = co_await this_coro::executor;
+      tcp::acceptor acceptor(ex, {ip::address_v6::loopback(), 0});
+
+      tcp::socket client(ex);
+      co_await client.async_connect(acceptor.local_endpoint());
+      auto server = co_await acceptor.async_accept();
+
+      auto send = [&]() -> awaitable<size_t>
+      {
+         std::vector<char> message(100, 'x');
+         for (size_t n = 0; n < size; n += message.size()) // last one shorter, if needed
+            co_await async_write(client, buffer(message, std::min(message.size(), size - n)));
+         client.shutdown(socket_base::shutdown_send);
+         co_return size;
+      };
+
+      auto echo = [&]() -> awaitable<size_t>
+      {
+         auto n = co_await pipelined_relay(server, server, 4, 1_k);
+         server.shutdown(socket_base::shutdown_send);
+         co_return n;
+      };
+
+      auto receive = [&]() -> awaitable<size_t>
+      {
+         std::vector<char> data(64_k);
+         size_t total = 0;
+         for (;;)
+         {
+            auto [ec, n] = co_await client.async_read_some(buffer(data), as_tuple);
+            total += n;
+            if (ec == error::eof)
+               co_return total;
+            else if (ec)
+               throw system_error(ec);
+         }
+      };
+
+      co_return co_await (send() && echo() && receive());
+   });
+   EXPECT_EQ(sent, size);
+   EXPECT_EQ(echoed, size);
+   EXPECT_EQ(received, size);
+}
+
+// =================================================================================================
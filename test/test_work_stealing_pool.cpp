@@ -0,0 +1,105 @@
+#include "async_invoke.hpp"
+#include "work_stealing_pool.hpp"
+
+#include <boost/asio.hpp>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace asio;
+
+// =================================================================================================
+
+TEST(WorkStealingPool, WHEN_async_invoke_THEN_result_is_delivered_to_handler_executor)
+{
+   io_context context;
+   WorkStealingPool pool(4);
+   auto ex = pool.get_executor();
+
+   int result = 0;
+   std::thread::id thread;
+   async_invoke(ex, bind_executor(context, [&](int value)
+   {
+      result = value;
+      thread = std::this_thread::get_id();
+   }), [] { return 42; });
+   context.run();
+
+   EXPECT_EQ(result, 42);
+   EXPECT_EQ(thread, std::this_thread::get_id());
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(WorkStealingPool, WHEN_co_spawn_THEN_coroutine_runs_in_pool)
+{
+   WorkStealingPool pool(2);
+   std::future<bool> future = co_spawn(pool, [&]() -> awaitable<bool>
+   {
+      auto in_pool = pool.running_in_this_thread();
+      co_await post(bind_executor(pool, use_awaitable)); // hop through the queue again
+      co_return in_pool && pool.running_in_this_thread();
+   }, use_future);
+   EXPECT_TRUE(future.get());
+   EXPECT_FALSE(pool.running_in_this_thread());
+}
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * Tasks submitted from outside and from within the pool, which keeps the owner's queue full and
+ * gives the other workers something to steal.
+ */
+TEST(WorkStealingPool, WHEN_many_tasks_THEN_join_waits_for_all)
+{
+   constexpr size_t producers = 4, tasks = 10'000;
+   std::atomic<size_t> count = 0;
+   WorkStealingPool pool(4);
+   {
+      std::vector<std::jthread> threads;
+      for (size_t i = 0; i < producers; ++i)
+         threads.emplace_back([&]
+         {
+            for (size_t j = 0; j < tasks; ++j)
+               post(pool, [&] { post(pool, [&] { ++count; }); });
+         });
+   }
+   pool.join();
+   EXPECT_EQ(count, producers * tasks);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(WorkStealingPool, WHEN_tracked_executor_THEN_join_waits_for_it)
+{
+   WorkStealingPool pool(2);
+   std::atomic<bool> done = false;
+   auto work = require(pool.get_executor(), execution::outstanding_work.tracked);
+   std::jthread thread([&, work = std::move(work)]() mutable
+   {
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      post(work, [&] { done = true; });
+      auto release = std::move(work);
+   });
+   pool.join();
+   EXPECT_TRUE(done);
+}
+
+// -------------------------------------------------------------------------------------------------
+
+TEST(WorkStealingPool, WHEN_blocking_possibly_THEN_runs_inline_in_pool)
+{
+   WorkStealingPool pool(1);
+   std::future<bool> future = co_spawn(pool, [&]() -> awaitable<bool>
+   {
+      bool inline_ = false;
+      dispatch(pool.get_executor(), [&] { inline_ = true; });
+      co_return inline_;
+   }, use_future);
+   EXPECT_TRUE(future.get());
+}
+
+// =================================================================================================
@@ -0,0 +1,46 @@
+#include "asio-coro.hpp"
+#include "run_sync.hpp"
+#include "stream_utils.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace ::testing;
+
+// =================================================================================================
+
+static_assert(ZerocopyStream<tcp::socket>);
+static_assert(!ZerocopyStream<readable_pipe>);
+
+// -------------------------------------------------------------------------------------------------
+
+/**
+ * On loopback, the kernel copies the data anyway, but it still sends a notification for every
+ * zerocopy send. So this checks that all of them are collected before write_zerocopy() completes.
+ */
+TEST(Zerocopy, WHEN_writing_THEN_completes_after_all_data_is_released)
+{
+   constexpr size_t size = 10_m;
+   auto [sent, received] = run_sync([&] -> awaitable<std::tuple<size_t, size_t>>
+   {
+      auto ex = co_await this_coro::executor;
+      tcp::acceptor acceptor(ex, {ip::address_v6::loopback(), 0});
+
+      tcp::socket source(ex);
+      co_await source.async_connect(acceptor.local_endpoint());
+      auto sink = co_await acceptor.async_accept();
+
+      auto send = [&]() -> awaitable<size_t>
+      {
+         std::vector<char> data(size, 'x');
+         auto n = co_await write_zerocopy(source, data);
+         source.shutdown(socket_base::shutdown_send);
+         co_return n;
+      };
+
+      co_return co_await (send() && count(std::move(sink)));
+   });
+   EXPECT_EQ(sent, size);
+   EXPECT_EQ(received, size);
+}
+
+// =================================================================================================